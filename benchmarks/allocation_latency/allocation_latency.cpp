@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/cxxopts.hpp>
+
+#include <rmm/mr/device/cuda_memory_resource.hpp>
+#include <rmm/mr/device/pool_memory_resource.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using pool_mr = rmm::mr::pool_memory_resource<rmm::mr::cuda_memory_resource>;
+
+constexpr std::size_t size_mb{1 << 20};
+
+int num_allocations      = 10000;  // per iteration
+int max_size             = 1 << 20;
+std::size_t initial_size = 16 * size_mb;
+std::size_t reserve      = 0;  // background refill reserve, 0 to disable
+std::size_t low_water    = 0;
+
+/**
+ * @brief Returns the value at percentile `p` (in [0, 1]) of the sorted `samples`.
+ */
+double percentile(std::vector<double> const& samples, double p)
+{
+  if (samples.empty()) { return 0.0; }
+  auto const index = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1));
+  return samples[index];
+}
+
+/**
+ * @brief Times each allocation of a growing working set of randomly-sized blocks in a pool that
+ * starts small, so that some allocations must grow the pool unless it is refilled in the
+ * background. Reports the latency percentiles of individual allocations, in microseconds.
+ *
+ * Background refill only keeps upstream allocations off the allocating thread if the reserve
+ * covers the growth of the working set between refills.
+ */
+static void BM_AllocationLatency(benchmark::State& state, bool background_refill)
+{
+  rmm::mr::cuda_memory_resource cuda{};
+  std::default_random_engine generator;
+  std::uniform_int_distribution<std::size_t> size_distribution(1, max_size);
+
+  std::vector<double> latencies;
+  std::vector<std::pair<void*, std::size_t>> allocations(num_allocations);
+  std::size_t blocking_expansions{};
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto mr = std::make_unique<pool_mr>(&cuda, initial_size);
+    if (background_refill) {
+      // As a latency-critical application would, wait for the reserve to be filled before starting
+      mr->set_background_refill(reserve, low_water);
+      while (mr->get_free_bytes() < low_water) {
+        std::this_thread::yield();
+      }
+    }
+    state.ResumeTiming();
+
+    for (auto& a : allocations) {
+      a.second         = size_distribution(generator);
+      auto const start = std::chrono::steady_clock::now();
+      a.first          = mr->allocate(a.second);
+      auto const end   = std::chrono::steady_clock::now();
+      latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    state.PauseTiming();
+    for (auto const& a : allocations) {
+      mr->deallocate(a.first, a.second);
+    }
+    blocking_expansions += mr->get_blocking_expansion_count();
+    mr.reset();
+    state.ResumeTiming();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["p50_us"]              = percentile(latencies, 0.5);
+  state.counters["p99_us"]              = percentile(latencies, 0.99);
+  state.counters["p999_us"]             = percentile(latencies, 0.999);
+  state.counters["max_us"]              = latencies.empty() ? 0.0 : latencies.back();
+  state.counters["blocking_expansions"] = benchmark::Counter(
+    static_cast<double>(blocking_expansions), benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations() * num_allocations);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  // benchmark::Initialize will remove GBench command line arguments it
+  // recognizes and leave any remaining arguments
+  ::benchmark::Initialize(&argc, argv);
+
+  cxxopts::Options options(
+    "RMM Allocation Latency Benchmark",
+    "Reports allocation latency percentiles of a growing pool, with and without background "
+    "refill.");
+
+  options.add_options()("n,numallocs",
+                        "Number of allocations per iteration",
+                        cxxopts::value<int>()->default_value("10000"));
+  options.add_options()("m,maxsize",
+                        "Maximum allocation size in bytes",
+                        cxxopts::value<int>()->default_value("1048576"));
+  options.add_options()("i,initial",
+                        "Initial pool size in MiB",
+                        cxxopts::value<std::size_t>()->default_value("16"));
+  options.add_options()("reserve",
+                        "Background refill reserve in MiB",
+                        cxxopts::value<std::size_t>()->default_value("1024"));
+  options.add_options()("lowwater",
+                        "Background refill low water mark in MiB",
+                        cxxopts::value<std::size_t>()->default_value("512"));
+
+  auto args       = options.parse(argc, argv);
+  num_allocations = args["numallocs"].as<int>();
+  max_size        = args["maxsize"].as<int>();
+  initial_size    = args["initial"].as<std::size_t>() * size_mb;
+  reserve         = args["reserve"].as<std::size_t>() * size_mb;
+  low_water       = args["lowwater"].as<std::size_t>() * size_mb;
+
+  benchmark::RegisterBenchmark("BM_AllocationLatency/pool", BM_AllocationLatency, false)
+    ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark("BM_AllocationLatency/pool_background_refill",
+                               BM_AllocationLatency,
+                               true)
+    ->Unit(benchmark::kMillisecond);
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
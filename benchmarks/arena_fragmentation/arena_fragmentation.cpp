@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/simulated_memory_resource.hpp>
+
+#include <rmm/mr/device/arena_memory_resource.hpp>
+#include <rmm/mr/device/detail/host_stream_backend.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t simulated_size{1u << 30u};
+constexpr std::size_t fragment_size{256};
+
+using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::simulated_memory_resource,
+                                                rmm::mr::detail::host_stream_backend>;
+
+/**
+ * @brief Allocates and frees blocks that fit none of the free blocks of a fragmented arena.
+ *
+ * Before timing, `state.range(0)` pairs of 256-byte blocks are allocated and then the first of
+ * every pair freed, leaving as many free 256-byte fragments interleaved with live blocks, as a
+ * workload that keeps small long-lived allocations alive does. Each timed iteration then allocates
+ * and frees a 512-byte block, which must be found past all of the fragments. The memory is
+ * simulated, so only the arena's free block lookup is measured.
+ */
+void BM_ArenaFragmented(benchmark::State& state)
+{
+  auto const num_fragments = static_cast<std::size_t>(state.range(0));
+
+  rmm::mr::simulated_memory_resource simulated{simulated_size};
+  arena_mr mr{&simulated, simulated_size, simulated_size};
+
+  std::vector<void*> blocks(2 * num_fragments);
+  for (auto& p : blocks) {
+    p = mr.allocate(fragment_size);
+  }
+  for (std::size_t i = 0; i < blocks.size(); i += 2) {
+    mr.deallocate(blocks[i], fragment_size);
+  }
+
+  for (auto _ : state) {
+    void* const p = mr.allocate(2 * fragment_size);
+    benchmark::DoNotOptimize(p);
+    mr.deallocate(p, 2 * fragment_size);
+  }
+
+  for (std::size_t i = 1; i < blocks.size(); i += 2) {
+    mr.deallocate(blocks[i], fragment_size);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ArenaFragmented)->RangeMultiplier(4)->Range(1 << 8, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/simulated_memory_resource.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/arena_memory_resource.hpp>
+#include <rmm/mr/device/detail/host_stream_backend.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t simulated_size{1u << 30u};
+constexpr std::size_t allocation_size{256};
+
+using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::simulated_memory_resource,
+                                                rmm::mr::detail::host_stream_backend>;
+
+/// The resource shared by all benchmark threads
+arena_mr& shared_arena()
+{
+  static rmm::mr::simulated_memory_resource simulated{simulated_size};
+  static arena_mr mr{&simulated, simulated_size, simulated_size};
+  return mr;
+}
+
+/**
+ * @brief Allocates and frees a small block on the per-thread default stream in every thread.
+ *
+ * Each thread has its own arena, so the arenas do not contend and the throughput measures the
+ * cost of finding the calling thread's arena as the number of threads grows. The memory is
+ * simulated, so no device memory is touched.
+ */
+void BM_ArenaThreadAllocations(benchmark::State& state)
+{
+  auto& mr = shared_arena();
+
+  for (auto _ : state) {
+    void* const p = mr.allocate(allocation_size, rmm::cuda_stream_per_thread);
+    benchmark::DoNotOptimize(p);
+    mr.deallocate(p, allocation_size, rmm::cuda_stream_per_thread);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+constexpr int max_threads{64};
+constexpr std::size_t batch_size{16};
+
+/// Blocks a thread has allocated and handed over to be freed by the next thread
+struct handoff {
+  std::mutex mtx;
+  std::vector<void*> blocks;
+};
+
+std::array<handoff, max_threads> handoffs;
+
+/**
+ * @brief A pipeline in which each thread allocates batches of blocks and frees the batches of the
+ * previous thread, so that every block is freed by a thread other than the one that allocated it.
+ */
+void BM_ArenaCrossThreadFrees(benchmark::State& state)
+{
+  auto& mr        = shared_arena();
+  auto& produced  = handoffs.at(state.thread_index);
+  auto& consumed  = handoffs.at((state.thread_index + 1) % state.threads);
+  auto const free = [&mr](std::vector<void*> const& blocks) {
+    for (auto* p : blocks) {
+      mr.deallocate(p, allocation_size, rmm::cuda_stream_per_thread);
+    }
+  };
+
+  std::vector<void*> batch;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch_size; ++i) {
+      batch.push_back(mr.allocate(allocation_size, rmm::cuda_stream_per_thread));
+    }
+    {
+      std::lock_guard<std::mutex> lock(produced.mtx);
+      produced.blocks.insert(produced.blocks.end(), batch.begin(), batch.end());
+    }
+    batch.clear();
+    {
+      std::lock_guard<std::mutex> lock(consumed.mtx);
+      batch.swap(consumed.blocks);
+    }
+    free(batch);
+    batch.clear();
+  }
+
+  // Only this thread adds to its handoff, so it is empty once this thread has taken the rest
+  {
+    std::lock_guard<std::mutex> lock(produced.mtx);
+    batch.swap(produced.blocks);
+  }
+  free(batch);
+
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+/**
+ * @brief Each iteration runs a short-lived thread that allocates and frees a batch of blocks, as
+ * in a thread pool that retires and replaces threads, so every thread's arena obtains superblocks
+ * and returns them when the thread is done. Reports how many superblocks the threads took from
+ * the global arena's superblock cache.
+ */
+void BM_ArenaThreadChurn(benchmark::State& state)
+{
+  auto& mr          = shared_arena();
+  auto const hits   = mr.get_superblock_cache_hits();
+  auto const misses = mr.get_superblock_cache_misses();
+  auto const work   = [&mr]() {
+    std::vector<void*> batch;
+    for (std::size_t i = 0; i < batch_size; ++i) {
+      batch.push_back(mr.allocate(allocation_size, rmm::cuda_stream_per_thread));
+    }
+    for (auto* p : batch) {
+      mr.deallocate(p, allocation_size, rmm::cuda_stream_per_thread);
+    }
+  };
+
+  for (auto _ : state) {
+    std::thread{work}.join();
+  }
+
+  state.SetItemsProcessed(state.iterations() * batch_size);
+  state.counters["cache_hits"]   = mr.get_superblock_cache_hits() - hits;
+  state.counters["cache_misses"] = mr.get_superblock_cache_misses() - misses;
+}
+
+}  // namespace
+
+BENCHMARK(BM_ArenaThreadAllocations)->ThreadRange(1, max_threads)->UseRealTime();
+BENCHMARK(BM_ArenaCrossThreadFrees)->ThreadRange(2, max_threads)->UseRealTime();
+BENCHMARK(BM_ArenaThreadChurn)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
+#include <rmm/mr/device/detail/tlsf_free_list.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace {
+
+using rmm::mr::detail::block;
+
+// Free lists never dereference block pointers, so fake addresses will do.
+char* const base = reinterpret_cast<char*>(0x10000);
+
+constexpr std::size_t block_size{256};
+
+/**
+ * @brief Fills `lhs` and `rhs` with `num_blocks` blocks each, interleaved in address order and
+ * separated by gaps, as the free lists of two streams that allocated from the same pool are.
+ * Every 16th pair of blocks is contiguous, so merging the lists also coalesces some blocks.
+ */
+template <typename FreeList>
+void make_fragmented_lists(std::size_t num_blocks, FreeList& lhs, FreeList& rhs)
+{
+  // In descending address order, so that each insert into a coalescing_free_list is O(1)
+  for (std::size_t i = num_blocks; i-- > 0;) {
+    auto* const ptr  = base + i * 4 * block_size;
+    auto const delta = (i % 16 == 0) ? block_size : 2 * block_size;
+    lhs.insert(block{ptr, block_size, false});
+    rhs.insert(block{ptr + delta, block_size, false});
+  }
+}
+
+/**
+ * @brief Merges two fragmented free lists of `state.range(0)` blocks each.
+ *
+ * With `bulk`, the lists are merged with `insert(free_list&&)`, otherwise the blocks of one list
+ * are inserted into the other one at a time, as a baseline.
+ */
+template <typename FreeList>
+void BM_MergeFreeLists(benchmark::State& state, bool bulk)
+{
+  auto const num_blocks = static_cast<std::size_t>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    FreeList lhs{};
+    FreeList rhs{};
+    make_fragmented_lists(num_blocks, lhs, rhs);
+    state.ResumeTiming();
+
+    if (bulk) {
+      lhs.insert(std::move(rhs));
+    } else {
+      for (auto const& b : rhs) {
+        lhs.insert(b);
+      }
+    }
+    benchmark::DoNotOptimize(lhs.size());
+
+    state.PauseTiming();
+    lhs.clear();
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_blocks * 2);
+}
+
+template <typename FreeList>
+void register_benchmark(std::string const& name, bool bulk)
+{
+  benchmark::RegisterBenchmark(
+    ("BM_MergeFreeLists/" + name).c_str(), BM_MergeFreeLists<FreeList>, bulk)
+    ->RangeMultiplier(4)
+    ->Range(1 << 8, 1 << 14)
+    ->Unit(benchmark::kMicrosecond);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  ::benchmark::Initialize(&argc, argv);
+
+  register_benchmark<rmm::mr::detail::coalescing_free_list>("coalescing/bulk", true);
+  register_benchmark<rmm::mr::detail::coalescing_free_list>("coalescing/one_at_a_time", false);
+  register_benchmark<rmm::mr::detail::indexed_free_list>("indexed/bulk", true);
+  register_benchmark<rmm::mr::detail::tlsf_free_list>("tlsf/bulk", true);
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/cxxopts.hpp>
+
+#include <rmm/cuda_stream.hpp>
+#include <rmm/mr/device/arena_memory_resource.hpp>
+#include <rmm/mr/device/cuda_memory_resource.hpp>
+#include <rmm/mr/device/device_memory_resource.hpp>
+#include <rmm/mr/device/owning_wrapper.hpp>
+#include <rmm/mr/device/pool_memory_resource.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// MR factory functions
+inline auto make_cuda() { return std::make_shared<rmm::mr::cuda_memory_resource>(); }
+
+inline auto make_pool()
+{
+  return rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(make_cuda());
+}
+
+inline auto make_arena()
+{
+  return rmm::mr::make_owning_wrapper<rmm::mr::arena_memory_resource>(make_cuda());
+}
+
+using MRFactoryFunc = std::function<std::shared_ptr<rmm::mr::device_memory_resource>()>;
+
+// The resource under test, shared by all benchmark threads. It is created before the threads
+// start so that its construction (and initial pool allocation) is not timed.
+std::shared_ptr<rmm::mr::device_memory_resource> shared_mr{};
+
+int num_allocations = 1000;   // per batch, per thread
+int max_size        = 65536;  // bytes
+
+/**
+ * @brief Each thread repeatedly allocates a batch of randomly-sized blocks on its own stream and
+ * then frees them in random order, so that throughput can be compared as the number of threads
+ * (and streams) grows.
+ */
+static void BM_MultiStreamAllocations(benchmark::State& state)
+{
+  rmm::cuda_stream stream{};
+  auto& mr = *shared_mr;
+
+  std::default_random_engine generator(state.thread_index);
+  std::uniform_int_distribution<std::size_t> size_distribution(1, max_size);
+
+  std::vector<std::pair<void*, std::size_t>> allocations(num_allocations);
+
+  for (auto _ : state) {
+    for (auto& a : allocations) {
+      a.second = size_distribution(generator);
+      a.first  = mr.allocate(a.second, stream.view());
+    }
+    std::shuffle(allocations.begin(), allocations.end(), generator);
+    for (auto const& a : allocations) {
+      mr.deallocate(a.first, a.second, stream.view());
+    }
+  }
+
+  stream.synchronize();
+  state.SetItemsProcessed(state.iterations() * num_allocations);
+}
+
+void declare_benchmark(std::string const& name)
+{
+  benchmark::RegisterBenchmark(("BM_MultiStreamAllocations/" + name).c_str(),
+                               BM_MultiStreamAllocations)
+    ->ThreadRange(1, 32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  // benchmark::Initialize will remove GBench command line arguments it
+  // recognizes and leave any remaining arguments
+  ::benchmark::Initialize(&argc, argv);
+
+  cxxopts::Options options("RMM Multi-Stream Allocations Benchmark",
+                           "Benchmarks allocation throughput with one stream per thread.");
+
+  options.add_options()("r,resource",
+                        "Type of device_memory_resource",
+                        cxxopts::value<std::string>()->default_value("pool"));
+  options.add_options()("n,numallocs",
+                        "Number of allocations per batch, per thread",
+                        cxxopts::value<int>()->default_value("1000"));
+  options.add_options()("m,maxsize",
+                        "Maximum allocation size in bytes",
+                        cxxopts::value<int>()->default_value("65536"));
+
+  auto args       = options.parse(argc, argv);
+  num_allocations = args["numallocs"].as<int>();
+  max_size        = args["maxsize"].as<int>();
+
+  std::map<std::string, MRFactoryFunc> const funcs(
+    {{"arena", &make_arena}, {"cuda", &make_cuda}, {"pool", &make_pool}});
+  auto const resource = args["resource"].as<std::string>();
+
+  shared_mr = funcs.at(resource)();
+  declare_benchmark(resource);
+  ::benchmark::RunSpecifiedBenchmarks();
+  shared_mr.reset();
+
+  return 0;
+}
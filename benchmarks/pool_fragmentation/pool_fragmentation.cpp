@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/simulated_memory_resource.hpp>
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/host_stream_backend.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
+#include <rmm/mr/device/pool_memory_resource.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t KiB{1 << 10};
+constexpr std::size_t MiB{1 << 20};
+
+constexpr std::size_t pool_size{1024 * MiB};
+constexpr std::size_t allocations_per_cycle{64};
+constexpr std::size_t large_size{1 * MiB};  // dual-ended threshold, and smallest large allocation
+
+struct allocation {
+  void* pointer;
+  std::size_t size;
+  std::size_t expiry;  // the cycle at the end of which the allocation is freed
+};
+
+/**
+ * @brief Runs `state.range(0)` churn cycles against a fixed-size pool with the given placement
+ * policy, and reports the largest block the pool could then allocate.
+ *
+ * Each cycle makes 64 allocations, of which on average one is large (1-16 MiB) and lives for 8
+ * to 64 cycles, and the others are small (256 B - 64 KiB) and live for 1 to 4 cycles, and then
+ * frees the allocations that have expired. The pool is simulated, so only its free lists are
+ * exercised. Allocations that fail for lack of a large enough free block are counted.
+ */
+template <typename FreeList>
+void BM_PoolFragmentation(benchmark::State& state, rmm::mr::pool_placement_policy policy)
+{
+  using pool_mr = rmm::mr::pool_memory_resource<rmm::mr::simulated_memory_resource,
+                                                FreeList,
+                                                rmm::mr::detail::host_stream_backend>;
+  auto const num_cycles = static_cast<std::size_t>(state.range(0));
+
+  std::size_t largest_free{};
+  std::size_t free_bytes{};
+  std::size_t failures{};
+
+  for (auto _ : state) {
+    rmm::mr::simulated_memory_resource simulated{pool_size};
+    pool_mr mr{&simulated, pool_size, pool_size};
+    mr.set_placement_policy(policy);
+
+    std::default_random_engine generator{42};
+    std::uniform_int_distribution<std::size_t> is_large(0, allocations_per_cycle - 1);
+    std::uniform_int_distribution<std::size_t> small_size(256, 64 * KiB);
+    std::uniform_int_distribution<std::size_t> large_size_dist(large_size, 16 * MiB);
+    std::uniform_int_distribution<std::size_t> small_life(1, 4);
+    std::uniform_int_distribution<std::size_t> large_life(8, 64);
+
+    std::vector<allocation> live;
+    failures = 0;
+    for (std::size_t cycle = 0; cycle < num_cycles; ++cycle) {
+      for (std::size_t i = 0; i < allocations_per_cycle; ++i) {
+        bool const large  = is_large(generator) == 0;
+        auto const size   = large ? large_size_dist(generator) : small_size(generator);
+        auto const expiry = cycle + (large ? large_life(generator) : small_life(generator));
+        try {
+          live.push_back({mr.allocate(size), size, expiry});
+        } catch (std::bad_alloc const&) {
+          ++failures;
+        }
+      }
+
+      auto const expired = std::partition(
+        live.begin(), live.end(), [cycle](allocation const& a) { return a.expiry > cycle; });
+      std::for_each(expired, live.end(), [&mr](allocation const& a) {
+        mr.deallocate(a.pointer, a.size);
+      });
+      live.erase(expired, live.end());
+    }
+
+    largest_free = mr.get_largest_free_block();
+    free_bytes   = mr.get_free_bytes();
+
+    for (auto const& a : live) {
+      mr.deallocate(a.pointer, a.size);
+    }
+  }
+
+  state.counters["largest_free_MiB"] = static_cast<double>(largest_free) / MiB;
+  state.counters["free_MiB"]         = static_cast<double>(free_bytes) / MiB;
+  state.counters["failed_allocs"]    = static_cast<double>(failures);
+}
+
+template <typename FreeList>
+void register_benchmark(std::string const& name, rmm::mr::pool_placement_policy policy)
+{
+  benchmark::RegisterBenchmark(
+    ("BM_PoolFragmentation/" + name).c_str(), BM_PoolFragmentation<FreeList>, policy)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024)
+    ->Unit(benchmark::kMillisecond);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  ::benchmark::Initialize(&argc, argv);
+
+  using rmm::mr::pool_placement_policy;
+  register_benchmark<rmm::mr::detail::coalescing_free_list>("coalescing/best_fit",
+                                                            pool_placement_policy::best_fit());
+  register_benchmark<rmm::mr::detail::coalescing_free_list>(
+    "coalescing/dual_ended", pool_placement_policy::dual_ended(large_size));
+  register_benchmark<rmm::mr::detail::indexed_free_list>("indexed/best_fit",
+                                                         pool_placement_policy::best_fit());
+  register_benchmark<rmm::mr::detail::indexed_free_list>(
+    "indexed/dual_ended", pool_placement_policy::dual_ended(large_size));
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
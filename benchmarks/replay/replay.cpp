@@ -20,10 +20,16 @@
 #include <benchmarks/utilities/simulated_memory_resource.hpp>
 
 #include <rmm/cuda_stream_view.hpp>
+#include <rmm/detail/aligned.hpp>
 #include <rmm/detail/error.hpp>
 #include <rmm/mr/device/arena_memory_resource.hpp>
 #include <rmm/mr/device/binning_memory_resource.hpp>
 #include <rmm/mr/device/cuda_memory_resource.hpp>
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/deferred_coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/host_stream_backend.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
+#include <rmm/mr/device/detail/tlsf_free_list.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/owning_wrapper.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
@@ -31,18 +37,25 @@
 #include <thrust/execution_policy.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/discard_iterator.h>
+#include <thrust/optional.h>
 #include <thrust/reduce.h>
 
 #include <benchmark/benchmark.h>
 
 #include <spdlog/common.h>
 
+#include <algorithm>
 #include <chrono>
 #include <iterator>
 #include <memory>
 #include <numeric>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
+
+// The minimum split size of pools, set from the command line
+std::size_t minimum_split_size{0};
 
 /// MR factory functions
 std::shared_ptr<rmm::mr::device_memory_resource> make_cuda(std::size_t = 0)
@@ -63,6 +76,50 @@ inline auto make_pool(std::size_t simulated_size)
                make_simulated(simulated_size), simulated_size, simulated_size);
 }
 
+/// Makes a pool that starts empty and grows according to `policy`, to compare growth policies
+inline auto make_growing_pool(std::size_t simulated_size, rmm::mr::pool_growth_policy policy)
+{
+  return simulated_size == 0
+           ? rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
+               make_cuda(), 0, thrust::nullopt, policy)
+           : rmm::mr::make_owning_wrapper<rmm::mr::pool_memory_resource>(
+               make_simulated(simulated_size), 0, simulated_size, policy);
+}
+
+template <typename FreeList>
+inline auto make_pool_with_free_list(std::size_t simulated_size)
+{
+  using pool    = rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource, FreeList>;
+  using wrapper = rmm::mr::owning_wrapper<pool, rmm::mr::device_memory_resource>;
+  return simulated_size == 0
+           ? std::make_shared<wrapper>(std::make_tuple(make_cuda()))
+           : std::make_shared<wrapper>(
+               std::make_tuple(make_simulated(simulated_size)), simulated_size, simulated_size);
+}
+
+inline auto make_coalescing_pool(std::size_t simulated_size)
+{
+  return make_pool_with_free_list<rmm::mr::detail::coalescing_free_list>(simulated_size);
+}
+
+inline auto make_tlsf_pool(std::size_t simulated_size)
+{
+  return make_pool_with_free_list<rmm::mr::detail::tlsf_free_list>(simulated_size);
+}
+
+inline auto make_deferred_pool(std::size_t simulated_size)
+{
+  return make_pool_with_free_list<
+    rmm::mr::detail::deferred_coalescing_free_list<rmm::mr::detail::indexed_free_list>>(
+    simulated_size);
+}
+
+inline auto make_coalescing_deferred_pool(std::size_t simulated_size)
+{
+  return make_pool_with_free_list<rmm::mr::detail::deferred_coalescing_free_list<>>(
+    simulated_size);
+}
+
 inline auto make_arena(std::size_t simulated_size)
 {
   return simulated_size == 0
@@ -71,6 +128,22 @@ inline auto make_arena(std::size_t simulated_size)
                make_simulated(simulated_size), simulated_size, simulated_size);
 }
 
+/**
+ * @brief Makes an arena that starts empty and grows geometrically, with the given superblock size
+ *
+ * @param simulated_size The size of the simulated GPU memory, or 0 to use CUDA memory
+ * @param superblock_size The minimum size of the superblocks of the per-thread arenas
+ */
+inline auto make_sized_arena(std::size_t simulated_size, std::size_t superblock_size)
+{
+  using global_arena = rmm::mr::detail::arena::global_arena<rmm::mr::device_memory_resource>;
+  auto upstream      = simulated_size == 0 ? make_cuda() : make_simulated(simulated_size);
+  std::size_t const maximum_size =
+    simulated_size == 0 ? global_arena::default_maximum_size : simulated_size;
+  return rmm::mr::make_owning_wrapper<rmm::mr::arena_memory_resource>(
+    upstream, 0, maximum_size, superblock_size, rmm::mr::arena_growth_policy::geometric());
+}
+
 inline auto make_binning(std::size_t simulated_size)
 {
   auto pool = make_pool(simulated_size);
@@ -81,6 +154,53 @@ inline auto make_binning(std::size_t simulated_size)
   return mr;
 }
 
+// Resources whose streams and events are simulated on the host, so that the streams in the log
+// can be replayed without a GPU. They require a simulated memory size.
+using host_stream_pool = rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource,
+                                                       rmm::mr::detail::indexed_free_list,
+                                                       rmm::mr::detail::host_stream_backend>;
+using host_stream_arena =
+  rmm::mr::arena_memory_resource<rmm::mr::device_memory_resource,
+                                 rmm::mr::detail::host_stream_backend>;
+
+/**
+ * @brief Makes a pool on host-simulated streams
+ *
+ * @param simulated_size The size of the simulated GPU memory
+ * @param policy If set, the pool starts empty and grows with this policy, otherwise it starts
+ * with all of the simulated memory
+ * @param group If not empty, these streams are registered as a stream group sharing a free list
+ */
+inline std::shared_ptr<rmm::mr::device_memory_resource> make_host_stream_pool(
+  std::size_t simulated_size,
+  thrust::optional<rmm::mr::pool_growth_policy> policy,
+  std::vector<rmm::cuda_stream_view> const& group)
+{
+  using wrapper = rmm::mr::owning_wrapper<host_stream_pool, rmm::mr::device_memory_resource>;
+  auto upstream = std::make_tuple(make_simulated(simulated_size));
+  auto mr       = policy.has_value()
+              ? std::make_shared<wrapper>(upstream, 0, simulated_size, policy.value())
+              : std::make_shared<wrapper>(upstream, simulated_size, simulated_size);
+  if (not group.empty()) { mr->wrapped().add_stream_group(group); }
+  return mr;
+}
+
+inline std::shared_ptr<rmm::mr::device_memory_resource> make_host_stream_arena(
+  std::size_t simulated_size)
+{
+  using wrapper = rmm::mr::owning_wrapper<host_stream_arena, rmm::mr::device_memory_resource>;
+  return std::make_shared<wrapper>(
+    std::make_tuple(make_simulated(simulated_size)), simulated_size, simulated_size);
+}
+
+/// Returns the stream on which a logged event occurred
+rmm::cuda_stream_view logged_stream(rmm::detail::event const& e)
+{
+  cudaStream_t cs;
+  memcpy(&cs, &e.stream, sizeof(cudaStream_t));
+  return rmm::cuda_stream_view{cs};
+}
+
 using MRFactoryFunc = std::function<std::shared_ptr<rmm::mr::device_memory_resource>(std::size_t)>;
 
 /**
@@ -89,9 +209,13 @@ using MRFactoryFunc = std::function<std::shared_ptr<rmm::mr::device_memory_resou
  */
 struct allocation {
   allocation() = default;
-  allocation(void* p_, std::size_t size_) : p{p_}, size{size_} {}
+  allocation(void* p_, std::size_t size_, rmm::cuda_stream_view stream_ = {})
+    : p{p_}, size{size_}, stream{stream_}
+  {
+  }
   void* p{};
   std::size_t size{};
+  rmm::cuda_stream_view stream{};
 };
 
 /**
@@ -104,6 +228,7 @@ struct allocation {
 struct replay_benchmark {
   MRFactoryFunc factory_;
   std::size_t simulated_size_;
+  bool logged_streams_;  // replay on the streams in the log rather than the default stream
   std::shared_ptr<rmm::mr::device_memory_resource> mr_{};
   std::vector<std::vector<rmm::detail::event>> const& events_{};
 
@@ -120,13 +245,16 @@ struct replay_benchmark {
    *
    * @param factory A factory function to create the memory resource
    * @param events The set of allocation events to replay
-   * @param args Variable number of arguments forward to the constructor of MR
+   * @param logged_streams If true, each event is replayed on the stream in the log, otherwise on
+   * the default stream
    */
   replay_benchmark(MRFactoryFunc factory,
                    std::size_t simulated_size,
-                   std::vector<std::vector<rmm::detail::event>> const& events)
+                   std::vector<std::vector<rmm::detail::event>> const& events,
+                   bool logged_streams = false)
     : factory_{std::move(factory)},
       simulated_size_{simulated_size},
+      logged_streams_{logged_streams},
       mr_{},
       events_{events},
       allocation_map{events.size()},
@@ -142,6 +270,7 @@ struct replay_benchmark {
   replay_benchmark(replay_benchmark&& other) noexcept
     : factory_{std::move(other.factory_)},
       simulated_size_{other.simulated_size_},
+      logged_streams_{other.logged_streams_},
       mr_{std::move(other.mr_)},
       events_{other.events_},
       allocation_map{events_.size()},
@@ -172,6 +301,7 @@ struct replay_benchmark {
     if (state.thread_index == 0) {
       rmm::logger().log(spdlog::level::info, "------ Start of Benchmark -----");
       mr_ = factory_(simulated_size_);
+      with_pool([](auto& pool) { pool.set_minimum_split_size(minimum_split_size); });
     }
   }
 
@@ -187,7 +317,7 @@ struct replay_benchmark {
         auto alloc = ptr_alloc.second;
         num_leaked++;
         total_leaked += alloc.size;
-        mr_->deallocate(alloc.p, alloc.size);
+        mr_->deallocate(alloc.p, alloc.size, alloc.stream);
       }
       if (num_leaked > 0)
         std::cout << "LOG shows leak of " << num_leaked << " allocations of " << total_leaked
@@ -212,12 +342,13 @@ struct replay_benchmark {
           cv.wait(lock, [&]() { return event_index == e.index; });
         }
 
+        auto const stream = logged_streams_ ? logged_stream(e) : rmm::cuda_stream_view{};
         if (rmm::detail::action::ALLOCATE == e.act) {
-          auto p = mr_->allocate(e.size);
-          set_allocation(e.pointer, allocation{p, e.size});
+          auto p = mr_->allocate(e.size, stream);
+          set_allocation(e.pointer, allocation{p, e.size, stream});
         } else {
           auto a = remove_allocation(e.pointer);
-          mr_->deallocate(a.p, e.size);
+          mr_->deallocate(a.p, e.size, stream);
         }
 
         event_index++;
@@ -225,30 +356,185 @@ struct replay_benchmark {
       });
     }
 
+    if (state.thread_index == 0) {
+      report_pool_stats(state);
+      report_arena_stats(state);
+    }
+
     TearDown(state);
   }
+
+  /**
+   * @brief If the memory resource is a pool, report how often and by how much it grew, how often
+   * allocations took blocks from other streams, and how fragmented its free memory is at the end
+   * of the replay (1 - largest free block / free bytes). Also reports the tail padding of the
+   * live allocations and the number of splits avoided by the minimum split size.
+   */
+  void report_pool_stats(::benchmark::State& state)
+  {
+    with_pool([&state](auto& pool) {
+      auto const sizes             = pool.get_expansion_sizes();
+      state.counters["expansions"] = sizes.size();
+      state.counters["expanded_MiB"] =
+        std::accumulate(sizes.begin(), sizes.end(), std::size_t{0}) / double{1 << 20};
+      state.counters["pool_MiB"]    = pool.pool_size() / double{1 << 20};
+      state.counters["steals"]      = pool.get_steal_count();
+      state.counters["free_steals"] = pool.get_free_steal_count();
+      state.counters["merges"]      = pool.get_merge_count();
+
+      auto const free_bytes = pool.get_free_bytes();
+      state.counters["fragmentation"] =
+        (free_bytes == 0) ? 0.0
+                          : 1.0 - static_cast<double>(pool.get_largest_free_block()) /
+                                    static_cast<double>(free_bytes);
+      state.counters["tail_padding_KiB"] = pool.get_tail_padding_bytes() / double{1 << 10};
+      state.counters["avoided_splits"]   = pool.get_avoided_split_count();
+    });
+  }
+
+  /**
+   * @brief If the memory resource is an arena, report its superblock size and how much memory its
+   * global arena allocated from upstream. The global arena never shrinks, so this is its peak
+   * footprint over the replay.
+   */
+  void report_arena_stats(::benchmark::State& state)
+  {
+    auto report = [&state](auto& arena) {
+      state.counters["superblock_KiB"] = arena.get_superblock_size() / double{1 << 10};
+      state.counters["arena_MiB"]      = arena.get_arena_size() / double{1 << 20};
+    };
+    with_pool_of_type<rmm::mr::arena_memory_resource<rmm::mr::device_memory_resource>>(report) or
+      with_pool_of_type<host_stream_arena>(report);
+  }
+
+  template <typename FreeList>
+  using pool_with_free_list =
+    rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource, FreeList>;
+
+  /**
+   * @brief If the memory resource is a pool, call `f` with the pool
+   *
+   * @return true if the memory resource is a pool
+   */
+  template <typename Function>
+  bool with_pool(Function&& f)
+  {
+    using rmm::mr::detail::coalescing_free_list;
+    using rmm::mr::detail::deferred_coalescing_free_list;
+    using rmm::mr::detail::indexed_free_list;
+    using rmm::mr::detail::tlsf_free_list;
+    return with_pool_of_type<pool_with_free_list<indexed_free_list>>(f) or
+           with_pool_of_type<pool_with_free_list<coalescing_free_list>>(f) or
+           with_pool_of_type<pool_with_free_list<tlsf_free_list>>(f) or
+           with_pool_of_type<
+             pool_with_free_list<deferred_coalescing_free_list<indexed_free_list>>>(f) or
+           with_pool_of_type<pool_with_free_list<deferred_coalescing_free_list<>>>(f) or
+           with_pool_of_type<host_stream_pool>(f);
+  }
+
+  template <typename Pool, typename Function>
+  bool with_pool_of_type(Function& f)
+  {
+    using pool_type = rmm::mr::owning_wrapper<Pool, rmm::mr::device_memory_resource>;
+    auto* pool      = dynamic_cast<pool_type*>(mr_.get());
+    if (pool == nullptr) { return false; }
+    f(pool->wrapped());
+    return true;
+  }
 };
 
+/**
+ * @brief Computes the peak number of bytes allocated at once over all threads' events
+ *
+ * @param per_thread_events The events of each thread
+ * @return The peak of the total size of live allocations
+ */
+std::size_t peak_allocated_bytes(
+  std::vector<std::vector<rmm::detail::event>> const& per_thread_events)
+{
+  std::vector<rmm::detail::event> all_events;
+  for (auto const& thread_events : per_thread_events) {
+    all_events.insert(all_events.end(), thread_events.begin(), thread_events.end());
+  }
+  std::sort(all_events.begin(), all_events.end(), [](auto const& lhs, auto const& rhs) {
+    return lhs.index < rhs.index;
+  });
+
+  std::size_t current{0};
+  std::size_t peak{0};
+  for (auto const& e : all_events) {
+    auto const size = rmm::detail::align_up(e.size, 256);
+    if (rmm::detail::action::ALLOCATE == e.act) {
+      current += size;
+      peak = std::max(peak, current);
+    } else {
+      current -= std::min(current, size);
+    }
+  }
+  return peak;
+}
+
+/**
+ * @brief Gets the distinct non-default streams on which events in the log occurred
+ *
+ * @param per_thread_events The events of each thread
+ * @return The streams, in order of first use
+ */
+std::vector<rmm::cuda_stream_view> non_default_streams(
+  std::vector<std::vector<rmm::detail::event>> const& per_thread_events)
+{
+  std::vector<rmm::cuda_stream_view> streams;
+  std::set<cudaStream_t> seen;
+  for (auto const& thread_events : per_thread_events) {
+    for (auto const& e : thread_events) {
+      auto const s = logged_stream(e);
+      if (not s.is_default() && not s.is_per_thread_default() && seen.insert(s.value()).second) {
+        streams.push_back(s);
+      }
+    }
+  }
+  return streams;
+}
+
+/**
+ * @brief Parses the name of a pool growth policy
+ *
+ * @param name One of "geometric", "fixed_chunk", "exact_fit" or "hinted"
+ * @param chunk_size The chunk size for the fixed_chunk policy
+ * @param expected_peak The expected peak pool size for the hinted policy
+ * @return The growth policy
+ */
+rmm::mr::pool_growth_policy make_growth_policy(std::string const& name,
+                                               std::size_t chunk_size,
+                                               std::size_t expected_peak)
+{
+  if (name == "fixed_chunk") return rmm::mr::pool_growth_policy::fixed_chunk(chunk_size);
+  if (name == "exact_fit") return rmm::mr::pool_growth_policy::exact_fit();
+  if (name == "hinted") return rmm::mr::pool_growth_policy::hinted(expected_peak);
+  RMM_EXPECTS(name == "geometric", "Invalid growth policy name");
+  return rmm::mr::pool_growth_policy::geometric();
+}
+
 /**
  * @brief Processes a log file into a set of per-thread vectors of events
  *
  * @param filename Name of log file
+ * @param host_streams If true, events may be on any stream, otherwise only on a default stream
  * @return A vector of events for each thread in the log
  */
-std::vector<std::vector<rmm::detail::event>> parse_per_thread_events(std::string const& filename)
+std::vector<std::vector<rmm::detail::event>> parse_per_thread_events(std::string const& filename,
+                                                                     bool host_streams)
 {
   using rmm::detail::event;
   std::vector<event> all_events = rmm::detail::parse_csv(filename);
 
-  RMM_EXPECTS(std::all_of(all_events.begin(),
-                          all_events.end(),
-                          [](auto const& e) {
-                            cudaStream_t cs;
-                            memcpy(&cs, &e.stream, sizeof(cudaStream_t));
-                            auto s = rmm::cuda_stream_view{cs};
-                            return s.is_default() or s.is_per_thread_default();
-                          }),
-              "Non-default streams not currently supported.");
+  RMM_EXPECTS(host_streams or std::all_of(all_events.begin(),
+                                          all_events.end(),
+                                          [](auto const& e) {
+                                            auto s = logged_stream(e);
+                                            return s.is_default() or s.is_per_thread_default();
+                                          }),
+              "Non-default streams are only supported with host streams.");
 
   // Sort events by thread id
   std::stable_sort(all_events.begin(), all_events.end(), [](auto lhs, auto rhs) {
@@ -292,9 +578,57 @@ std::vector<std::vector<rmm::detail::event>> parse_per_thread_events(std::string
 void declare_benchmark(std::string const& name,
                        std::size_t simulated_size,
                        std::vector<std::vector<rmm::detail::event>> const& per_thread_events,
-                       std::size_t num_threads)
+                       std::size_t num_threads,
+                       thrust::optional<rmm::mr::pool_growth_policy> growth_policy,
+                       bool host_streams,
+                       std::vector<std::size_t> const& superblock_sizes)
 {
-  if (name == "cuda")
+  if (host_streams) {
+    if (name == "pool") {
+      // Compare one free list per stream with all non-default streams sharing one free list
+      auto const streams = non_default_streams(per_thread_events);
+      benchmark::RegisterBenchmark(
+        "Pool Resource (host streams)",
+        replay_benchmark(
+          [growth_policy](std::size_t size) {
+            return make_host_stream_pool(size, growth_policy, {});
+          },
+          simulated_size,
+          per_thread_events,
+          true))
+        ->Unit(benchmark::kMillisecond)
+        ->Threads(num_threads);
+      if (streams.size() > 1) {
+        benchmark::RegisterBenchmark(
+          "Pool Resource (host streams, grouped)",
+          replay_benchmark(
+            [growth_policy, streams](std::size_t size) {
+              return make_host_stream_pool(size, growth_policy, streams);
+            },
+            simulated_size,
+            per_thread_events,
+            true))
+          ->Unit(benchmark::kMillisecond)
+          ->Threads(num_threads);
+      }
+    } else if (name == "arena")
+      benchmark::RegisterBenchmark(
+        "Arena Resource (host streams)",
+        replay_benchmark(&make_host_stream_arena, simulated_size, per_thread_events, true))
+        ->Unit(benchmark::kMillisecond)
+        ->Threads(num_threads);
+    else
+      std::cout << "Error: host streams are not supported for memory_resource: " << name << "\n";
+  } else if (name == "pool" && growth_policy.has_value()) {
+    auto const policy = growth_policy.value();
+    benchmark::RegisterBenchmark(
+      "Pool Resource (growing)",
+      replay_benchmark([policy](std::size_t size) { return make_growing_pool(size, policy); },
+                       simulated_size,
+                       per_thread_events))
+      ->Unit(benchmark::kMillisecond)
+      ->Threads(num_threads);
+  } else if (name == "cuda")
     benchmark::RegisterBenchmark("CUDA Resource",
                                  replay_benchmark(&make_cuda, simulated_size, per_thread_events))
       ->Unit(benchmark::kMillisecond)
@@ -309,6 +643,45 @@ void declare_benchmark(std::string const& name,
                                  replay_benchmark(&make_pool, simulated_size, per_thread_events))
       ->Unit(benchmark::kMillisecond)
       ->Threads(num_threads);
+  else if (name == "pool_coalescing")
+    benchmark::RegisterBenchmark(
+      "Pool Resource (coalescing_free_list)",
+      replay_benchmark(&make_coalescing_pool, simulated_size, per_thread_events))
+      ->Unit(benchmark::kMillisecond)
+      ->Threads(num_threads);
+  else if (name == "pool_deferred")
+    benchmark::RegisterBenchmark(
+      "Pool Resource (deferred_coalescing_free_list<indexed_free_list>)",
+      replay_benchmark(&make_deferred_pool, simulated_size, per_thread_events))
+      ->Unit(benchmark::kMillisecond)
+      ->Threads(num_threads);
+  else if (name == "pool_coalescing_deferred")
+    benchmark::RegisterBenchmark(
+      "Pool Resource (deferred_coalescing_free_list<coalescing_free_list>)",
+      replay_benchmark(&make_coalescing_deferred_pool, simulated_size, per_thread_events))
+      ->Unit(benchmark::kMillisecond)
+      ->Threads(num_threads);
+  else if (name == "pool_tlsf")
+    benchmark::RegisterBenchmark(
+      "Pool Resource (tlsf_free_list)",
+      replay_benchmark(&make_tlsf_pool, simulated_size, per_thread_events))
+      ->Unit(benchmark::kMillisecond)
+      ->Threads(num_threads);
+  else if (name == "arena" && not superblock_sizes.empty())
+    // Sweep the superblock size of an arena that grows as needed, to compare throughput against
+    // the memory it holds
+    for (auto const superblock_size : superblock_sizes) {
+      auto const bench_name =
+        "Arena Resource (superblock " + std::to_string(superblock_size >> 10) + " KiB)";
+      benchmark::RegisterBenchmark(
+        bench_name.c_str(),
+        replay_benchmark(
+          [superblock_size](std::size_t size) { return make_sized_arena(size, superblock_size); },
+          simulated_size,
+          per_thread_events))
+        ->Unit(benchmark::kMillisecond)
+        ->Threads(num_threads);
+    }
   else if (name == "arena")
     benchmark::RegisterBenchmark("Arena Resource",
                                  replay_benchmark(&make_arena, simulated_size, per_thread_events))
@@ -333,12 +706,35 @@ int main(int argc, char** argv)
 
     options.add_options()("f,file", "Name of RMM log file.", cxxopts::value<std::string>());
     options.add_options()("r,resource",
-                          "Type of device_memory_resource",
+                          "Type of device_memory_resource: pool, pool_coalescing, pool_tlsf, "
+                          "pool_deferred, pool_coalescing_deferred, arena, binning or cuda",
                           cxxopts::value<std::string>()->default_value("pool"));
     options.add_options()("s,size",
                           "Size of simulated GPU memory in GiB. Not supported for the cuda memory "
                           "resource.",
                           cxxopts::value<float>()->default_value("0"));
+    options.add_options()("g,growth",
+                          "Pool growth policy: geometric, fixed_chunk, exact_fit or hinted. If "
+                          "set, the pool starts empty and grows with this policy. The hinted "
+                          "policy is given the peak allocated size of the log.",
+                          cxxopts::value<std::string>());
+    options.add_options()("c,chunk",
+                          "Chunk size in MiB for the fixed_chunk growth policy.",
+                          cxxopts::value<std::size_t>()->default_value("64"));
+    options.add_options()("H,host_streams",
+                          "Replay each event on the stream in the log, with streams and events "
+                          "simulated on the host. Requires a simulated GPU memory size and the "
+                          "pool or arena resource. For the pool, also replays with all "
+                          "non-default streams in one stream group.",
+                          cxxopts::value<bool>()->default_value("false"));
+    options.add_options()("m,min_split",
+                          "Minimum split size of pools in bytes. Remainders of free blocks "
+                          "smaller than this are allocated as tail padding rather than split off.",
+                          cxxopts::value<std::size_t>()->default_value("0"));
+    options.add_options()("b,superblocks",
+                          "Comma-separated list of arena superblock sizes in KiB. If set, the "
+                          "arena starts empty, grows geometrically, and is replayed once per size.",
+                          cxxopts::value<std::vector<std::size_t>>());
     options.add_options()("v,verbose",
                           "Enable verbose printing of log events",
                           cxxopts::value<bool>()->default_value("false"));
@@ -353,9 +749,11 @@ int main(int argc, char** argv)
     return args;
   }();
 
-  auto filename = args["file"].as<std::string>();
+  auto filename      = args["file"].as<std::string>();
+  minimum_split_size = args["min_split"].as<std::size_t>();
+  auto host_streams  = args["host_streams"].as<bool>();
 
-  auto per_thread_events = parse_per_thread_events(filename);
+  auto per_thread_events = parse_per_thread_events(filename, host_streams);
 
 #ifdef CUDA_API_PER_THREAD_DEFAULT_STREAM
   std::cout << "Using CUDA per-thread default stream.\n";
@@ -366,6 +764,8 @@ int main(int argc, char** argv)
   if (simulated_size != 0 && args["resource"].as<std::string>() != "cuda") {
     std::cout << "Simulating GPU with memory size of " << simulated_size << " bytes.\n";
   }
+  RMM_EXPECTS(not host_streams or simulated_size != 0,
+              "Host streams require a simulated GPU memory size.");
 
   std::cout << "Total Events: "
             << std::accumulate(
@@ -386,18 +786,60 @@ int main(int argc, char** argv)
 
   auto const num_threads = per_thread_events.size();
 
+  auto const growth_policy = [&]() -> thrust::optional<rmm::mr::pool_growth_policy> {
+    if (args.count("growth") == 0) { return thrust::nullopt; }
+    auto const peak = peak_allocated_bytes(per_thread_events);
+    std::cout << "Peak allocated bytes: " << peak << "\n";
+    return make_growth_policy(
+      args["growth"].as<std::string>(), args["chunk"].as<std::size_t>() << 20, peak);
+  }();
+
+  auto const superblock_sizes = [&]() {
+    std::vector<std::size_t> sizes;
+    if (args.count("superblocks") > 0) {
+      for (auto const kib : args["superblocks"].as<std::vector<std::size_t>>()) {
+        sizes.push_back(kib << 10);
+      }
+    }
+    return sizes;
+  }();
+
   // Uncomment to enable / change default log level
   // rmm::logger().set_level(spdlog::level::trace);
 
   if (args.count("resource") > 0) {
     std::string mr_name = args["resource"].as<std::string>();
-    declare_benchmark(mr_name, simulated_size, per_thread_events, num_threads);
+    declare_benchmark(mr_name,
+                      simulated_size,
+                      per_thread_events,
+                      num_threads,
+                      growth_policy,
+                      host_streams,
+                      superblock_sizes);
   } else {
-    std::array<std::string, 4> mrs{"pool", "arena", "binning", "cuda"};
+    std::array<std::string, 8> mrs{"pool",
+                                   "pool_coalescing",
+                                   "pool_tlsf",
+                                   "pool_deferred",
+                                   "pool_coalescing_deferred",
+                                   "arena",
+                                   "binning",
+                                   "cuda"};
     std::for_each(std::cbegin(mrs),
                   std::cend(mrs),
-                  [&simulated_size, &per_thread_events, &num_threads](auto const& s) {
-                    declare_benchmark(s, simulated_size, per_thread_events, num_threads);
+                  [&simulated_size,
+                   &per_thread_events,
+                   &num_threads,
+                   &growth_policy,
+                   host_streams,
+                   &superblock_sizes](auto const& s) {
+                    declare_benchmark(s,
+                                      simulated_size,
+                                      per_thread_events,
+                                      num_threads,
+                                      growth_policy,
+                                      host_streams,
+                                      superblock_sizes);
                   });
   }
 
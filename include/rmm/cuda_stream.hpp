@@ -21,9 +21,104 @@
 
 #include <cuda_runtime_api.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace rmm {
+namespace detail {
+
+/**
+ * @brief Functions called when a `cuda_stream` is about to destroy its stream, so that memory
+ * resources can reclaim state they keep for the stream.
+ *
+ * Callbacks are called with the stream still valid, without holding the registry's lock, so that
+ * streams destroyed concurrently do not wait for each other's callbacks. Removing a callback waits
+ * for any call to it in progress to return.
+ */
+class stream_destruction_callbacks {
+ public:
+  using callback = std::function<void(cuda_stream_view)>;
+
+  /**
+   * @brief Register `f` to be called for each stream destroyed.
+   *
+   * @return std::size_t An identifier to pass to `remove()`.
+   */
+  static std::size_t add(callback f)
+  {
+    auto& c = instance();
+    std::lock_guard<std::mutex> lock(c.mtx_);
+    c.entries_[++c.next_id_] = std::make_shared<entry>(std::move(f));
+    return c.next_id_;
+  }
+
+  /**
+   * @brief Unregister the callback identified by `id`, waiting for calls to it in progress.
+   *
+   * Must not be called from a callback.
+   */
+  static void remove(std::size_t id)
+  {
+    auto& c = instance();
+    std::unique_lock<std::mutex> lock(c.mtx_);
+    auto const iter = c.entries_.find(id);
+    if (iter == c.entries_.end()) { return; }
+    auto const e = iter->second;
+    c.entries_.erase(iter);
+    e->removed = true;
+    c.cv_.wait(lock, [&e]() { return e->in_flight == 0; });
+  }
+
+  /// Call every registered callback with `stream`, which is about to be destroyed.
+  static void notify(cuda_stream_view stream)
+  {
+    auto& c = instance();
+    std::vector<std::shared_ptr<entry>> entries;
+    {
+      std::lock_guard<std::mutex> lock(c.mtx_);
+      entries.reserve(c.entries_.size());
+      for (auto const& id_entry : c.entries_) {
+        ++id_entry.second->in_flight;
+        entries.push_back(id_entry.second);
+      }
+    }
+
+    for (auto const& e : entries) {
+      if (not e->removed) { e->f(stream); }
+      std::lock_guard<std::mutex> lock(c.mtx_);
+      if (--e->in_flight == 0) { c.cv_.notify_all(); }
+    }
+  }
+
+ private:
+  /// A registered callback and the number of calls to it in progress.
+  struct entry {
+    explicit entry(callback fn) : f{std::move(fn)} {}
+    callback f;
+    std::size_t in_flight{};           // calls started and not yet returned. Guarded by mtx_
+    std::atomic<bool> removed{false};  // set by remove(), after which no call starts
+  };
+
+  // Never destroyed, so that streams and resources may outlive it during static destruction
+  static stream_destruction_callbacks& instance()
+  {
+    static auto* c = new stream_destruction_callbacks{};
+    return *c;
+  }
+
+  std::mutex mtx_;
+  std::condition_variable cv_;  // notified when a call finishes with no others in progress
+  std::map<std::size_t, std::shared_ptr<entry>> entries_;
+  std::size_t next_id_{};
+};
+
+}  // namespace detail
 
 /**
  * @brief Owning wrapper for a CUDA stream.
@@ -53,6 +148,9 @@ class cuda_stream {
   /**
    * @brief Construct a new cuda stream object
    *
+   * Before the stream is destroyed, the callbacks registered with
+   * `detail::stream_destruction_callbacks` are notified.
+   *
    * @throw rmm::cuda_error if stream creation fails
    */
   cuda_stream()
@@ -62,6 +160,7 @@ class cuda_stream {
                 return s;
               }(),
               [](cudaStream_t* s) {
+                detail::stream_destruction_callbacks::notify(cuda_stream_view{*s});
                 RMM_ASSERT_CUDA_SUCCESS(cudaStreamDestroy(*s));
                 delete s;
               }}
@@ -17,16 +17,25 @@
 
 #include <rmm/detail/error.hpp>
 #include <rmm/mr/device/detail/arena.hpp>
+#include <rmm/mr/device/detail/cuda_stream_backend.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 
 #include <cuda_runtime_api.h>
 
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <new>
+#include <tuple>
+#include <utility>
 #include <shared_mutex>
 
 namespace rmm {
 namespace mr {
 
+/// Determines how the global arena of an `arena_memory_resource` grows.
+using arena_growth_policy = detail::arena::growth_policy;
+
 /**
  * @brief A suballocator that emphasizes fragmentation avoidance and scalable concurrency support.
  *
@@ -37,9 +46,24 @@ namespace mr {
  * arenas for non-default streams. Each arena allocates memory from the global arena in chunks
  * called superblocks.
  *
- * Blocks in each arena are allocated using address-ordered first fit. When a block is freed, it is
- * coalesced with neighbouring free blocks if the addresses are contiguous. Free superblocks are
- * returned to the global arena.
+ * Memory freed on a thread or stream other than the one that allocated it is returned to the
+ * arena that owns it, found in a table of superblock owners, through a lock-free queue that the
+ * arena collects when it next allocates or deallocates.
+ *
+ * Blocks in each arena are allocated using best fit, choosing the lowest address of equally sized
+ * blocks, which each arena finds in logarithmic time in a size index of its free blocks. When a
+ * block is freed, it is coalesced with neighbouring free blocks if the addresses are contiguous.
+ * Free superblocks are returned to the global arena, which caches a few of them so that arenas
+ * of threads that come and go hand superblocks to each other without taking its lock.
+ *
+ * The superblock size trades throughput for fragmentation: larger superblocks let each arena
+ * serve more allocations without taking the global arena's lock, but hold more memory that other
+ * arenas cannot use. By default the global arena grows to its maximum size at once; an
+ * `arena_growth_policy` may instead grow it in fixed chunks or geometrically, so that it only
+ * holds as much upstream memory as the application needs.
+ *
+ * Each thread caches a pointer to its arena in the resource it last allocated from on the
+ * per-thread default stream, so that in the steady state finding the arena takes no lock.
  *
  * In real-world applications, allocation sizes tend to follow a power law distribution in which
  * large allocations are rare, but small ones quite common. By handling small allocations in the
@@ -65,8 +89,10 @@ namespace mr {
  *
  * @tparam Upstream Memory resource to use for allocating memory for the global arena. Implements
  * rmm::mr::device_memory_resource interface.
+ * @tparam StreamBackend The implementation of stream synchronization: `detail::cuda_stream_backend`
+ * (the default), or `detail::host_stream_backend` to simulate streams on the host.
  */
-template <typename Upstream>
+template <typename Upstream, typename StreamBackend = detail::cuda_stream_backend>
 class arena_memory_resource final : public device_memory_resource {
  public:
   /**
@@ -77,17 +103,34 @@ class arena_memory_resource final : public device_memory_resource {
    * 256 bytes.
    * @throws rmm::logic_error if `maximum_size` is neither the default nor aligned to a multiple of
    * 256 bytes.
+   * @throws rmm::logic_error if `superblock_size` is zero or not a multiple of 256 bytes.
    *
    * @param upstream_mr The memory resource from which to allocate blocks for the pool
    * @param initial_size Minimum size, in bytes, of the initial global arena. Defaults to half of
    * the available memory on the current device.
    * @param maximum_size Maximum size, in bytes, that the global arena can grow to. Defaults to all
-   * of the available memory on the current device.
+   * of the available memory on the current device, less `reserved_size`.
+   * @param superblock_size Minimum size, in bytes, of the superblocks that the per-thread and
+   * per-stream arenas allocate from the global arena. Defaults to 256 KiB.
+   * @param growth_policy Determines how much memory the global arena allocates from `upstream_mr`
+   * when it must grow. Defaults to growing to `maximum_size` at once.
+   * @param reserved_size Size, in bytes, of the available device memory to leave unallocated if
+   * `maximum_size` is the default. Defaults to 64 MiB.
    */
-  explicit arena_memory_resource(Upstream* upstream_mr,
-                                 std::size_t initial_size = global_arena::default_initial_size,
-                                 std::size_t maximum_size = global_arena::default_maximum_size)
-    : global_arena_{upstream_mr, initial_size, maximum_size}
+  explicit arena_memory_resource(
+    Upstream* upstream_mr,
+    std::size_t initial_size          = global_arena::default_initial_size,
+    std::size_t maximum_size          = global_arena::default_maximum_size,
+    std::size_t superblock_size       = detail::arena::default_superblock_size,
+    arena_growth_policy growth_policy = arena_growth_policy::all_at_once(),
+    std::size_t reserved_size         = global_arena::default_reserved_size)
+    : global_arena_{upstream_mr,
+                    initial_size,
+                    maximum_size,
+                    superblock_size,
+                    growth_policy,
+                    reserved_size},
+      id_{next_resource_id()}
   {
   }
 
@@ -110,16 +153,51 @@ class arena_memory_resource final : public device_memory_resource {
    */
   bool supports_get_mem_info() const noexcept override { return false; }
 
+  /**
+   * @brief Returns the minimum size of the superblocks allocated by the arenas.
+   *
+   * @return std::size_t The superblock size in bytes.
+   */
+  std::size_t get_superblock_size() const noexcept { return global_arena_.superblock_size(); }
+
+  /**
+   * @brief Returns the amount of memory the global arena has allocated from upstream.
+   *
+   * @return std::size_t The size in bytes of the global arena.
+   */
+  std::size_t get_arena_size() const { return global_arena_.size(); }
+
+  /**
+   * @brief Returns the number of superblocks arenas took from the superblock cache.
+   *
+   * @return std::size_t The number of superblock cache hits.
+   */
+  std::size_t get_superblock_cache_hits() const noexcept
+  {
+    return global_arena_.superblock_cache_hits();
+  }
+
+  /**
+   * @brief Returns the number of times arenas needed a superblock and the cache was empty.
+   *
+   * @return std::size_t The number of superblock cache misses.
+   */
+  std::size_t get_superblock_cache_misses() const noexcept
+  {
+    return global_arena_.superblock_cache_misses();
+  }
+
  private:
   using global_arena = detail::arena::global_arena<Upstream>;
-  using arena        = detail::arena::arena<Upstream>;
+  using arena        = detail::arena::arena<Upstream, StreamBackend>;
   using read_lock    = std::shared_lock<std::shared_timed_mutex>;
   using write_lock   = std::lock_guard<std::shared_timed_mutex>;
 
   /**
    * @brief Allocates memory of size at least `bytes`.
    *
-   * The returned pointer has at least 256-byte alignment.
+   * The returned pointer has at least 256-byte alignment. If the global arena is exhausted, every
+   * arena collects the memory other threads have freed for it, and the allocation is retried.
    *
    * @throws `std::bad_alloc` if the requested allocation could not be fulfilled.
    *
@@ -132,7 +210,30 @@ class arena_memory_resource final : public device_memory_resource {
     if (bytes <= 0) return nullptr;
 
     bytes = detail::arena::align_up(bytes);
-    return get_arena(stream).allocate(bytes);
+    auto& a = get_arena(stream);
+    try {
+      return a.allocate(bytes);
+    } catch (std::bad_alloc const&) {
+      collect_remote_frees();
+      return a.allocate(bytes);
+    }
+  }
+
+  /**
+   * @brief Have every arena free the memory queued for it by other threads or streams.
+   *
+   * An arena whose thread is idle never collects its queue itself, so its superblocks would not
+   * return to the global arena.
+   */
+  void collect_remote_frees()
+  {
+    read_lock lock(mtx_);
+    for (auto const& thread_arena : thread_arenas_) {
+      thread_arena.second->collect_remote_frees();
+    }
+    for (auto& stream_arena : stream_arenas_) {
+      stream_arena.second.collect_remote_frees();
+    }
   }
 
   /**
@@ -156,6 +257,9 @@ class arena_memory_resource final : public device_memory_resource {
   /**
    * @brief Deallocate memory pointed to by `p` that was allocated in a different arena.
    *
+   * The owning arena is looked up in the table of superblock owners, and the memory queued for it
+   * to free.
+   *
    * @param p Pointer to be deallocated.
    * @param bytes The size in bytes of the allocation. This must be equal to the
    * value of `bytes` that was passed to the `allocate` call that returned `p`.
@@ -163,27 +267,15 @@ class arena_memory_resource final : public device_memory_resource {
    */
   void deallocate_from_other_arena(void* p, std::size_t bytes, cuda_stream_view stream)
   {
-    stream.synchronize_no_throw();
-
-    read_lock lock(mtx_);
+    RMM_ASSERT_CUDA_SUCCESS(StreamBackend::synchronize_stream(stream.value()));
 
-    if (use_per_thread_arena(stream)) {
-      auto const id = std::this_thread::get_id();
-      for (auto& kv : thread_arenas_) {
-        // If the arena does not belong to the current thread, try to deallocate from it, and return
-        // if successful.
-        if (kv.first != id && kv.second->deallocate(p, bytes)) return;
-      }
-    } else {
-      for (auto& kv : stream_arenas_) {
-        // If the arena does not belong to the current stream, try to deallocate from it, and return
-        // if successful.
-        if (stream != kv.first && kv.second.deallocate(p, bytes)) return;
-      }
+    auto* const owner = owners_.find(p);
+    if (owner != nullptr) {
+      owner->deallocate_remote(p, bytes);
+      return;
     }
 
-    // The thread that originally allocated the block has terminated, deallocate directly in the
-    // global arena.
+    // Not in any arena's superblock, so deallocate directly in the global arena.
     global_arena_.deallocate({p, bytes});
   }
 
@@ -209,21 +301,47 @@ class arena_memory_resource final : public device_memory_resource {
    */
   arena& get_thread_arena()
   {
+    // The arena of the resource this thread last used, which is valid while the resource lives.
+    // Resource ids are never reused, so a slot left by a destroyed resource does not match.
+    thread_local cached_thread_arena cached{};
+    if (cached.resource_id == id_) { return *cached.thread_arena; }
+
     auto const id = std::this_thread::get_id();
     {
       read_lock lock(mtx_);
       auto const it = thread_arenas_.find(id);
-      if (it != thread_arenas_.end()) { return *it->second; }
+      if (it != thread_arenas_.end()) {
+        cached = {id_, it->second.get()};
+        return *it->second;
+      }
     }
     {
       write_lock lock(mtx_);
-      auto a = std::make_shared<arena>(global_arena_);
+      auto a = std::make_shared<arena>(global_arena_, owners_);
       thread_arenas_.emplace(id, a);
-      thread_local detail::arena::arena_cleaner<Upstream> cleaner{a};
+      thread_local detail::arena::arena_cleaner<Upstream, StreamBackend> cleaner{a};
+      cached = {id_, a.get()};
       return *a;
     }
   }
 
+  /**
+   * @brief A thread's cached pointer to its arena in the resource it last used.
+   */
+  struct cached_thread_arena {
+    std::uint64_t resource_id{};  ///< Id of the resource, or 0 if none.
+    arena* thread_arena{};        ///< The thread's arena in that resource.
+  };
+
+  /**
+   * @brief Returns a new id for a resource, unique among all resources of this type.
+   */
+  static std::uint64_t next_resource_id()
+  {
+    static std::atomic<std::uint64_t> next_id{0};
+    return ++next_id;
+  }
+
   /**
    * @brief Get the arena associated with the given stream.
    *
@@ -239,7 +357,9 @@ class arena_memory_resource final : public device_memory_resource {
     }
     {
       write_lock lock(mtx_);
-      stream_arenas_.emplace(stream.value(), global_arena_);
+      stream_arenas_.emplace(std::piecewise_construct,
+                             std::forward_as_tuple(stream.value()),
+                             std::forward_as_tuple(global_arena_, owners_));
       return stream_arenas_.at(stream.value());
     }
   }
@@ -268,6 +388,8 @@ class arena_memory_resource final : public device_memory_resource {
 
   /// The global arena to allocate superblocks from.
   global_arena global_arena_;
+  /// The arenas that own the superblocks allocated from the global arena.
+  detail::arena::superblock_owners<arena> owners_;
   /// Arenas for default streams, one per thread.
   /// Implementation note: for small sizes, map is more efficient than unordered_map.
   std::map<std::thread::id, std::shared_ptr<arena>> thread_arenas_;
@@ -276,6 +398,8 @@ class arena_memory_resource final : public device_memory_resource {
   std::map<cudaStream_t, arena> stream_arenas_;
   /// Mutex for read and write locks.
   mutable std::shared_timed_mutex mtx_;
+  /// Unique id of this resource, to validate threads' cached arena pointers.
+  std::uint64_t const id_;
 };
 
 }  // namespace mr
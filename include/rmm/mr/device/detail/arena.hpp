@@ -19,28 +19,44 @@
 #include <rmm/cuda_stream_view.hpp>
 #include <rmm/detail/aligned.hpp>
 #include <rmm/detail/error.hpp>
+#include <rmm/mr/device/detail/cuda_stream_backend.hpp>
 
 #include <cuda_runtime_api.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace rmm {
 namespace mr {
 namespace detail {
 namespace arena {
 
-/// Minimum size of a superblock (256 KiB).
-constexpr std::size_t minimum_superblock_size = 1u << 18u;
+/// The default size of a superblock (256 KiB).
+constexpr std::size_t default_superblock_size = 1u << 18u;
+
+/// The number of free superblocks the global arena caches.
+constexpr std::size_t superblock_cache_size = 16;
+
+/// The number of remote frees an arena can queue before other threads must take its lock.
+constexpr std::size_t remote_free_queue_size = 256;
 
 /**
  * @brief Represents a chunk of memory that can be allocated and deallocated.
  *
- * A block bigger than a certain size is called a "superblock".
+ * A block at least as large as the superblock size of the arenas is called a "superblock". A block
+ * that starts a separate allocation from the upstream resource is a "head", which is never merged
+ * with the block before it, so that no block spans two upstream allocations.
  */
 class block {
  public:
@@ -54,16 +70,24 @@ class block {
    *
    * @param pointer The address for the beginning of the block.
    * @param size The size of the block.
+   * @param is_head Whether the block starts an upstream allocation.
    */
-  block(char* pointer, size_t size) : pointer_(pointer), size_(size) {}
+  block(char* pointer, size_t size, bool is_head = false)
+    : pointer_(pointer), size_(size), head_(is_head)
+  {
+  }
 
   /**
    * @brief Construct a block given a void pointer and size.
    *
    * @param pointer The address for the beginning of the block.
    * @param size The size of the block.
+   * @param is_head Whether the block starts an upstream allocation.
    */
-  block(void* pointer, size_t size) : pointer_(static_cast<char*>(pointer)), size_(size) {}
+  block(void* pointer, size_t size, bool is_head = false)
+    : pointer_(static_cast<char*>(pointer)), size_(size), head_(is_head)
+  {
+  }
 
   /// Returns the underlying pointer.
   void* pointer() const { return pointer_; }
@@ -74,8 +98,8 @@ class block {
   /// Returns true if this block is valid (non-null), false otherwise.
   bool is_valid() const { return pointer_ != nullptr; }
 
-  /// Returns true if this block is a superblock, false otherwise.
-  bool is_superblock() const { return size_ >= minimum_superblock_size; }
+  /// Returns true if this block starts an upstream allocation, false otherwise.
+  bool is_head() const { return head_; }
 
   /**
    * @brief Verifies whether this block can be merged to the beginning of block b.
@@ -84,7 +108,10 @@ class block {
    * @return true Returns true if this block's `pointer` + `size` == `b.ptr`, and `not b.is_head`,
                   false otherwise.
    */
-  bool is_contiguous_before(block const& b) const { return pointer_ + size_ == b.pointer_; }
+  bool is_contiguous_before(block const& b) const
+  {
+    return pointer_ + size_ == b.pointer_ && !b.head_;
+  }
 
   /**
    * @brief Is this block large enough to fit `sz` bytes?
@@ -104,7 +131,7 @@ class block {
   {
     RMM_LOGGING_ASSERT(size_ >= sz);
     if (size_ > sz) {
-      return {{pointer_, sz}, {pointer_ + sz, size_ - sz}};
+      return {{pointer_, sz, head_}, {pointer_ + sz, size_ - sz}};
     } else {
       return {*this, {}};
     }
@@ -121,7 +148,7 @@ class block {
   block merge(block const& b) const
   {
     RMM_LOGGING_ASSERT(is_contiguous_before(b));
-    return {pointer_, size_ + b.size_};
+    return {pointer_, size_ + b.size_, head_};
   }
 
   /// Used by std::set to compare blocks.
@@ -130,6 +157,7 @@ class block {
  private:
   char* pointer_{};     ///< Raw memory pointer.
   std::size_t size_{};  ///< Size in bytes.
+  bool head_{};         ///< Whether the block starts an upstream allocation.
 };
 
 /// The required allocation alignment.
@@ -158,87 +186,504 @@ constexpr std::size_t align_down(std::size_t v) noexcept
 }
 
 /**
- * @brief Get the first free block of at least `size` bytes.
+ * @brief Orders blocks by size, then by address.
+ */
+struct compare_block_sizes {
+  bool operator()(block const& lhs, block const& rhs) const
+  {
+    return lhs.size() < rhs.size() || (lhs.size() == rhs.size() && lhs < rhs);
+  }
+};
+
+/**
+ * @brief A set of free blocks ordered by address and indexed by size.
+ *
+ * The address order is used to find the neighbours of a freed block for coalescing, and the size
+ * index to find a block that fits an allocation in O(log n) time. Both are updated together.
+ */
+class free_block_set {
+ public:
+  using const_iterator = std::set<block>::const_iterator;
+
+  /// Beginning of the address-ordered blocks.
+  const_iterator begin() const noexcept { return blocks_.cbegin(); }
+  /// Beginning of the address-ordered blocks.
+  const_iterator cbegin() const noexcept { return blocks_.cbegin(); }
+  /// End of the address-ordered blocks.
+  const_iterator end() const noexcept { return blocks_.cend(); }
+  /// End of the address-ordered blocks.
+  const_iterator cend() const noexcept { return blocks_.cend(); }
+
+  /// Returns true if there are no free blocks.
+  bool empty() const noexcept { return blocks_.empty(); }
+
+  /// Returns the number of free blocks.
+  std::size_t size() const noexcept { return blocks_.size(); }
+
+  /**
+   * @brief Returns an iterator to the first block whose address is not less than that of `b`.
+   *
+   * @param b The block to look up.
+   */
+  const_iterator lower_bound(block const& b) const { return blocks_.lower_bound(b); }
+
+  /**
+   * @brief Returns the smallest block of at least `size` bytes, the one with the lowest address
+   * if there are several, or an empty block if there is none.
+   *
+   * @param size The number of bytes the block must fit.
+   */
+  block smallest_fit(std::size_t size) const
+  {
+    auto const iter = sizes_.lower_bound(block{static_cast<char*>(nullptr), size});
+    return iter == sizes_.cend() ? block{} : *iter;
+  }
+
+  /**
+   * @brief Inserts a block, which must not overlap any block in the set.
+   *
+   * @param b The block to insert.
+   */
+  void insert(block const& b)
+  {
+    blocks_.insert(b);
+    sizes_.insert(b);
+  }
+
+  /**
+   * @brief Removes the block `iter` refers to.
+   *
+   * @param iter An iterator to the block to remove.
+   */
+  void erase(const_iterator iter)
+  {
+    sizes_.erase(*iter);
+    blocks_.erase(iter);
+  }
+
+  /**
+   * @brief Removes block `b`, if it is in the set.
+   *
+   * @param b The block to remove.
+   */
+  void erase(block const& b)
+  {
+    auto const iter = blocks_.find(b);
+    if (iter != blocks_.cend()) { erase(iter); }
+  }
+
+  /// Removes all blocks.
+  void clear() noexcept
+  {
+    blocks_.clear();
+    sizes_.clear();
+  }
+
+ private:
+  std::set<block> blocks_;                     ///< Blocks ordered by address.
+  std::set<block, compare_block_sizes> sizes_;  ///< The same blocks ordered by size.
+};
+
+/**
+ * @brief Get the smallest free block of at least `size` bytes, splitting off any excess.
  *
- * Address-ordered first-fit has shown to perform slightly better than best-fit when it comes to
- * memory fragmentation, and slightly cheaper to implement. It is also used by some popular
- * allocators such as jemalloc.
+ * Of several equally small blocks, the one with the lowest address is used. Both address-ordered
+ * first fit and best fit with address-ordered tie-breaking have been shown to have very low
+ * memory fragmentation in practice. Best fit can be found in O(log n) time in the size index of
+ * the free blocks, where first fit takes a linear search.
  *
  * \see Johnstone, M. S., & Wilson, P. R. (1998). The memory fragmentation problem: Solved?. ACM
  * Sigplan Notices, 34(3), 26-36.
  *
- * @param free_blocks The address-ordered set of free blocks.
+ * @param free_blocks The set of free blocks.
  * @param size The number of bytes to allocate.
  * @return block A block of memory of at least `size` bytes, or an empty block if not found.
  */
-inline block first_fit(std::set<block>& free_blocks, std::size_t size)
+inline block best_fit(free_block_set& free_blocks, std::size_t size)
 {
-  auto const iter = std::find_if(
-    free_blocks.cbegin(), free_blocks.cend(), [size](auto const& b) { return b.fits(size); });
-
-  if (iter == free_blocks.cend()) {
-    return {};
-  } else {
-    // Remove the block from the free_list.
-    auto const b = *iter;
-    auto const i = free_blocks.erase(iter);
-
-    if (b.size() > size) {
-      // Split the block and put the remainder back.
-      auto const split = b.split(size);
-      free_blocks.insert(i, split.second);
-      return split.first;
-    } else {
-      return b;
-    }
+  auto const b = free_blocks.smallest_fit(size);
+  if (!b.is_valid()) { return {}; }
+
+  // Remove the block from the free list, and put back any remainder.
+  free_blocks.erase(b);
+  if (b.size() > size) {
+    auto const split = b.split(size);
+    free_blocks.insert(split.second);
+    return split.first;
   }
+  return b;
 }
 
 /**
  * @brief Coalesce the given block with other free blocks.
  *
- * @param free_blocks The address-ordered set of free blocks.
+ * @param free_blocks The set of free blocks.
  * @param b The block to coalesce.
  * @return block The coalesced block.
  */
-inline block coalesce_block(std::set<block>& free_blocks, block const& b)
+inline block coalesce_block(free_block_set& free_blocks, block const& b)
 {
   if (!b.is_valid()) return b;
 
   // Find the right place (in ascending address order) to insert the block.
   auto const next     = free_blocks.lower_bound(b);
-  auto const previous = next == free_blocks.cbegin() ? next : std::prev(next);
+  auto const previous = next == free_blocks.cbegin() ? free_blocks.cend() : std::prev(next);
 
   // Coalesce with neighboring blocks.
-  bool const merge_prev = previous->is_contiguous_before(b);
+  bool const merge_prev = previous != free_blocks.cend() && previous->is_contiguous_before(b);
   bool const merge_next = next != free_blocks.cend() && b.is_contiguous_before(*next);
 
-  block merged{};
-  if (merge_prev && merge_next) {
-    merged = previous->merge(b).merge(*next);
+  block merged = b;
+  if (merge_next) {
+    merged = merged.merge(*next);
+    free_blocks.erase(next);
+  }
+  if (merge_prev) {
+    merged = previous->merge(merged);
     free_blocks.erase(previous);
-    auto const i = free_blocks.erase(next);
-    free_blocks.insert(i, merged);
-  } else if (merge_prev) {
-    merged       = previous->merge(b);
-    auto const i = free_blocks.erase(previous);
-    free_blocks.insert(i, merged);
-  } else if (merge_next) {
-    merged       = b.merge(*next);
-    auto const i = free_blocks.erase(next);
-    free_blocks.insert(i, merged);
-  } else {
-    free_blocks.emplace(b);
-    merged = b;
   }
+  free_blocks.insert(merged);
   return merged;
 }
 
+/**
+ * @brief Determines how many bytes the global arena requests from its upstream resource when it
+ * must grow.
+ *
+ * Whatever the policy, an expansion is never smaller than the request that requires it, and is
+ * clamped so that the arena does not exceed its maximum size.
+ */
+class growth_policy {
+ public:
+  /// The available growth policies
+  enum class kind {
+    all_at_once,  ///< Grow to the maximum size at once
+    fixed_chunk,  ///< Grow by the smallest multiple of a fixed chunk size
+    geometric     ///< Double the arena
+  };
+
+  /**
+   * @brief Grow to the maximum size of the arena at the first expansion.
+   *
+   * This is the default policy.
+   */
+  static growth_policy all_at_once() noexcept { return growth_policy{kind::all_at_once, 0}; }
+
+  /**
+   * @brief Grow by the smallest multiple of `chunk_size` bytes large enough for the request.
+   *
+   * @throws rmm::logic_error if `chunk_size` is zero or not a multiple of 256 bytes.
+   *
+   * @param chunk_size The size in bytes of each chunk.
+   */
+  static growth_policy fixed_chunk(std::size_t chunk_size)
+  {
+    RMM_EXPECTS(chunk_size > 0 && chunk_size == align_up(chunk_size),
+                "Error, chunk size required to be a non-zero multiple of 256 bytes");
+    return growth_policy{kind::fixed_chunk, chunk_size};
+  }
+
+  /**
+   * @brief Grow by the current size of the arena, i.e. double it, or by the size of the request
+   * if that is larger.
+   */
+  static growth_policy geometric() noexcept { return growth_policy{kind::geometric, 0}; }
+
+  /// Returns the kind of this policy.
+  kind get_kind() const noexcept { return kind_; }
+
+  /**
+   * @brief Computes the number of bytes to request from upstream.
+   *
+   * @param size The (aligned) size in bytes of the request that requires the arena to grow.
+   * @param current_size The current size in bytes of the arena.
+   * @param maximum_size The maximum size in bytes of the arena.
+   * @return std::size_t The number of bytes to grow the arena by, or 0 if growing by `size` bytes
+   * would exceed `maximum_size`.
+   */
+  std::size_t size_to_grow(std::size_t size,
+                           std::size_t current_size,
+                           std::size_t maximum_size) const noexcept
+  {
+    auto const remaining = maximum_size - current_size;
+    if (size > remaining) { return 0; }
+
+    auto const grow_size = [&]() {
+      switch (kind_) {
+        case kind::fixed_chunk: return (size + param_ - 1) / param_ * param_;
+        case kind::geometric: return std::max(size, current_size);
+        default: return remaining;
+      }
+    }();
+    return std::min(grow_size, remaining);
+  }
+
+ private:
+  growth_policy(kind k, std::size_t param) noexcept : kind_{k}, param_{param} {}
+
+  kind kind_;          // the growth policy
+  std::size_t param_;  // chunk size for fixed_chunk, otherwise unused
+};
+
+/**
+ * @brief A table of the address ranges of superblocks and the arenas that own them.
+ *
+ * An arena registers each superblock it obtains from the global arena, and unregisters memory
+ * before it returns it to the global arena. The owner of any allocated pointer can then be looked
+ * up in O(log n) time in the number of superblocks, instead of by asking every arena.
+ *
+ * @tparam Owner The type of arena that owns superblocks.
+ */
+template <typename Owner>
+class superblock_owners {
+ public:
+  /**
+   * @brief Register `owner` as the owner of the memory of block `b`.
+   *
+   * @param b The block, which must not overlap memory registered to another owner.
+   * @param owner The owner of the block.
+   */
+  void insert(block const& b, Owner* owner)
+  {
+    auto* const begin = static_cast<char*>(b.pointer());
+    write_lock lock(mtx_);
+    erase_range(begin, begin + b.size());
+    ranges_.emplace(begin, range{begin + b.size(), owner});
+  }
+
+  /**
+   * @brief Unregister the memory of block `b`, which may be any part of one or more registered
+   * superblocks.
+   *
+   * @param b The block to unregister.
+   */
+  void erase(block const& b)
+  {
+    auto* const begin = static_cast<char*>(b.pointer());
+    write_lock lock(mtx_);
+    erase_range(begin, begin + b.size());
+  }
+
+  /**
+   * @brief Find the owner of the memory `p` points to.
+   *
+   * @param p The pointer to look up.
+   * @return Owner* The owner of the superblock containing `p`, or nullptr if there is none.
+   */
+  Owner* find(void* p) const
+  {
+    auto* const ptr = static_cast<char*>(p);
+    read_lock lock(mtx_);
+    auto const iter = ranges_.upper_bound(ptr);
+    if (iter == ranges_.cbegin()) { return nullptr; }
+    auto const& r = std::prev(iter)->second;
+    return ptr < r.end ? r.owner : nullptr;
+  }
+
+ private:
+  using read_lock  = std::shared_lock<std::shared_timed_mutex>;
+  using write_lock = std::lock_guard<std::shared_timed_mutex>;
+
+  /// The end and owner of a registered range.
+  struct range {
+    char* end;
+    Owner* owner;
+  };
+
+  /// Removes [begin, end) from the registered ranges, keeping the parts of ranges outside it.
+  void erase_range(char* begin, char* end)
+  {
+    auto iter = ranges_.lower_bound(begin);
+    if (iter != ranges_.begin()) {
+      auto const previous = std::prev(iter);
+      auto const r        = previous->second;
+      if (r.end > begin) {
+        previous->second.end = begin;
+        if (r.end > end) {
+          ranges_.emplace_hint(iter, end, range{r.end, r.owner});
+          return;
+        }
+      }
+    }
+    while (iter != ranges_.end() && iter->first < end) {
+      auto const r = iter->second;
+      iter         = ranges_.erase(iter);
+      if (r.end > end) {
+        ranges_.emplace_hint(iter, end, r);
+        return;
+      }
+    }
+  }
+
+  std::map<char*, range> ranges_;  ///< Registered ranges by start address.
+  mutable std::shared_timed_mutex mtx_;
+};
+
+/**
+ * @brief A bounded lock-free cache of free superblocks of a single size.
+ *
+ * Each slot holds the pointer of a free superblock or nullptr, and is claimed and emptied with a
+ * single atomic operation, so superblocks can be handed from one arena to another without taking
+ * a lock. The cache counts how often a superblock is taken from it (hits) and how often it is
+ * empty (misses).
+ */
+class superblock_cache {
+ public:
+  superblock_cache() = default;
+
+  // Disable copy (and move) semantics.
+  superblock_cache(superblock_cache const&) = delete;
+  superblock_cache& operator=(superblock_cache const&) = delete;
+
+  /**
+   * @brief Put a free superblock into the cache if it is not full.
+   *
+   * @param p Pointer to the superblock.
+   * @return true if the superblock was cached, false if the cache is full.
+   */
+  bool insert(void* p) noexcept
+  {
+    for (auto& slot : slots_) {
+      void* expected{nullptr};
+      if (slot.load() == nullptr && slot.compare_exchange_strong(expected, p)) { return true; }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Take a free superblock from the cache, counting a hit, or a miss if it is empty.
+   *
+   * @return void* Pointer to the superblock, or nullptr if the cache is empty.
+   */
+  void* take() noexcept
+  {
+    auto* const p = take_any();
+    ++(p == nullptr ? misses_ : hits_);
+    return p;
+  }
+
+  /**
+   * @brief Take every superblock from the cache, without counting hits or misses.
+   *
+   * @param f Function called with the pointer of each superblock.
+   */
+  template <typename Function>
+  void drain(Function&& f)
+  {
+    for (auto& slot : slots_) {
+      auto* const p = slot.exchange(nullptr);
+      if (p != nullptr) { f(p); }
+    }
+  }
+
+  /// Returns the number of superblocks taken from the cache.
+  std::size_t hits() const noexcept { return hits_.load(); }
+
+  /// Returns the number of times a superblock was wanted but the cache was empty.
+  std::size_t misses() const noexcept { return misses_.load(); }
+
+ private:
+  /// Empties the first non-empty slot, returning its superblock, or nullptr if there is none.
+  void* take_any() noexcept
+  {
+    for (auto& slot : slots_) {
+      if (slot.load() != nullptr) {
+        auto* const p = slot.exchange(nullptr);
+        if (p != nullptr) { return p; }
+      }
+    }
+    return nullptr;
+  }
+
+  std::array<std::atomic<void*>, superblock_cache_size> slots_{};  ///< Cached superblocks.
+  std::atomic<std::size_t> hits_{0};                               ///< Superblocks taken.
+  std::atomic<std::size_t> misses_{0};                             ///< Takes from an empty cache.
+};
+
+/**
+ * @brief A bounded lock-free queue of blocks freed by other threads, for one arena to collect.
+ *
+ * Any number of threads may push, while a single thread at a time pops. Each slot carries a
+ * sequence number that tells pushers whether it is empty and the popper whether it is full, so a
+ * push or pop is a few atomic operations on preallocated storage.
+ */
+class remote_free_queue {
+ public:
+  remote_free_queue() noexcept
+  {
+    for (std::size_t i = 0; i < remote_free_queue_size; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Disable copy (and move) semantics.
+  remote_free_queue(remote_free_queue const&) = delete;
+  remote_free_queue& operator=(remote_free_queue const&) = delete;
+
+  /**
+   * @brief Queue block `b` if the queue is not full.
+   *
+   * @param b The freed block.
+   * @return true if the block was queued, false if the queue is full.
+   */
+  bool push(block const& b) noexcept
+  {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& s        = slots_[tail % remote_free_queue_size];
+      auto const seq = s.sequence.load(std::memory_order_acquire);
+      if (seq == tail) {
+        if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+          s.freed = b;
+          s.sequence.store(tail + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (seq < tail) {
+        return false;  // the slot still holds the block pushed a lap ago
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Take the oldest queued block. Must not be called by two threads at once.
+   *
+   * @return block The block, or an invalid block if none is ready.
+   */
+  block pop() noexcept
+  {
+    auto& s = slots_[head_ % remote_free_queue_size];
+    if (s.sequence.load(std::memory_order_acquire) != head_ + 1) { return {}; }
+    auto const b = s.freed;
+    s.sequence.store(head_ + remote_free_queue_size, std::memory_order_release);
+    ++head_;
+    return b;
+  }
+
+ private:
+  /// A queued block, and the position at which it may next be pushed (if equal to the tail) or
+  /// popped (if one past the head).
+  struct slot {
+    std::atomic<std::size_t> sequence;
+    block freed;
+  };
+
+  std::array<slot, remote_free_queue_size> slots_{};  ///< Queued blocks.
+  std::atomic<std::size_t> tail_{0};                  ///< Position of the next push.
+  std::size_t head_{0};                               ///< Position of the next pop.
+};
+
 /**
  * @brief The global arena for allocating memory from the upstream memory resource.
  *
  * The global arena is a shared memory pool from which other arenas allocate superblocks.
  *
+ * Free superblocks returned by arenas, for example when their threads exit, are kept in a small
+ * lock-free cache in front of the global arena's free blocks, so that the next arena to need a
+ * superblock takes one without the global arena's lock and without coalescing it first. The cache
+ * is emptied into the free blocks only when no free block fits an allocation.
+ *
  * @tparam Upstream Memory resource to use for allocating the arena. Implements
  * rmm::mr::device_memory_resource interface.
  */
@@ -249,8 +694,8 @@ class global_arena final {
   static constexpr std::size_t default_initial_size = std::numeric_limits<std::size_t>::max();
   /// The default maximum size for the global arena.
   static constexpr std::size_t default_maximum_size = std::numeric_limits<std::size_t>::max();
-  /// Reserved memory that should not be allocated (64 MiB).
-  static constexpr std::size_t reserved_size = 1u << 26u;
+  /// The default size of device memory that should not be allocated (64 MiB).
+  static constexpr std::size_t default_reserved_size = 1u << 26u;
 
   /**
    * @brief Construct a global arena.
@@ -260,17 +705,33 @@ class global_arena final {
    * 256 bytes.
    * @throws rmm::logic_error if `maximum_size` is neither the default nor aligned to a multiple of
    * 256 bytes.
+   * @throws rmm::logic_error if `superblock_size` is zero or not a multiple of 256 bytes.
    *
    * @param upstream_mr The memory resource from which to allocate blocks for the pool
    * @param initial_size Minimum size, in bytes, of the initial global arena. Defaults to half of
    * the available memory on the current device.
    * @param maximum_size Maximum size, in bytes, that the global arena can grow to. Defaults to all
-   * of the available memory on the current device.
+   * of the available memory on the current device, less `reserved_size`.
+   * @param superblock_size The minimum size, in bytes, of the superblocks arenas allocate.
+   * @param policy Determines how much memory to allocate from `upstream_mr` when the global arena
+   * must grow.
+   * @param reserved_size The size, in bytes, of the available device memory to leave unallocated
+   * if `maximum_size` is the default.
    */
-  global_arena(Upstream* upstream_mr, std::size_t initial_size, std::size_t maximum_size)
-    : upstream_mr_{upstream_mr}, maximum_size_{maximum_size}
+  global_arena(Upstream* upstream_mr,
+               std::size_t initial_size,
+               std::size_t maximum_size,
+               std::size_t superblock_size = default_superblock_size,
+               growth_policy policy        = growth_policy::all_at_once(),
+               std::size_t reserved_size   = default_reserved_size)
+    : upstream_mr_{upstream_mr},
+      maximum_size_{maximum_size},
+      superblock_size_{superblock_size},
+      growth_policy_{policy}
   {
     RMM_EXPECTS(nullptr != upstream_mr_, "Unexpected null upstream pointer.");
+    RMM_EXPECTS(superblock_size_ > 0 && superblock_size_ == align_up(superblock_size_),
+                "Error, Superblock size required to be a non-zero multiple of 256 bytes");
     RMM_EXPECTS(initial_size == default_initial_size || initial_size == align_up(initial_size),
                 "Error, Initial arena size required to be a multiple of 256 bytes");
     RMM_EXPECTS(maximum_size_ == default_maximum_size || maximum_size_ == align_up(maximum_size_),
@@ -288,7 +749,7 @@ class global_arena final {
     }
     RMM_EXPECTS(initial_size <= maximum_size_, "Initial arena size exceeds the maximum pool size!");
 
-    free_blocks_.emplace(expand_arena(initial_size));
+    if (initial_size > 0) { free_blocks_.insert(expand_arena(initial_size)); }
   }
 
   // Disable copy (and move) semantics.
@@ -307,6 +768,16 @@ class global_arena final {
     }
   }
 
+  /// Returns the minimum size in bytes of the superblocks arenas allocate.
+  std::size_t superblock_size() const noexcept { return superblock_size_; }
+
+  /// Returns the number of bytes allocated from the upstream resource.
+  std::size_t size() const
+  {
+    lock_guard lock(mtx_);
+    return current_size_;
+  }
+
   /**
    * @brief Allocates memory of size at least `bytes`.
    *
@@ -317,6 +788,10 @@ class global_arena final {
    */
   block allocate(std::size_t bytes)
   {
+    if (bytes == superblock_size_) {
+      auto* const p = superblock_cache_.take();
+      if (p != nullptr) { return uncached_superblock(p); }
+    }
     lock_guard lock(mtx_);
     return get_block(bytes);
   }
@@ -324,14 +799,20 @@ class global_arena final {
   /**
    * @brief Deallocate memory pointed to by `p`.
    *
+   * Whole superblocks of `b` are cached while the cache has room; the rest is coalesced into the
+   * free blocks.
+   *
    * @param p Pointer to be deallocated.
    * @param bytes The size in bytes of the allocation. This must be equal to the value of `bytes`
    * that was passed to the `allocate` call that returned `p`.
    */
   void deallocate(block const& b)
   {
-    lock_guard lock(mtx_);
-    coalesce_block(free_blocks_, b);
+    auto const remainder = cache_superblocks(b);
+    if (remainder.is_valid()) {
+      lock_guard lock(mtx_);
+      coalesce_block(free_blocks_, remainder);
+    }
   }
 
   /**
@@ -339,14 +820,27 @@ class global_arena final {
    *
    * @param free_blocks The set of free blocks.
    */
-  void deallocate(std::set<block> const& free_blocks)
+  void deallocate(free_block_set const& free_blocks)
   {
-    lock_guard lock(mtx_);
+    std::vector<block> remainders;
     for (auto const& b : free_blocks) {
+      auto const remainder = cache_superblocks(b);
+      if (remainder.is_valid()) { remainders.push_back(remainder); }
+    }
+    if (remainders.empty()) { return; }
+
+    lock_guard lock(mtx_);
+    for (auto const& b : remainders) {
       coalesce_block(free_blocks_, b);
     }
   }
 
+  /// Returns the number of superblocks taken from the superblock cache.
+  std::size_t superblock_cache_hits() const noexcept { return superblock_cache_.hits(); }
+
+  /// Returns the number of superblocks wanted while the superblock cache was empty.
+  std::size_t superblock_cache_misses() const noexcept { return superblock_cache_.misses(); }
+
  private:
   using lock_guard = std::lock_guard<std::mutex>;
 
@@ -358,30 +852,74 @@ class global_arena final {
    */
   block get_block(std::size_t size)
   {
-    // Find the first-fit free block.
-    auto const b = first_fit(free_blocks_, size);
+    // Find the best-fit free block.
+    auto const b = best_fit(free_blocks_, size);
     if (b.is_valid()) return b;
 
+    // Coalesce the cached superblocks and try again.
+    auto drained = false;
+    superblock_cache_.drain([this, &drained](void* p) {
+      coalesce_block(free_blocks_, uncached_superblock(p));
+      drained = true;
+    });
+    if (drained) {
+      auto const coalesced = best_fit(free_blocks_, size);
+      if (coalesced.is_valid()) return coalesced;
+    }
+
     // No existing larger blocks available, so grow the arena.
     auto const upstream_block = expand_arena(size_to_grow(size));
     coalesce_block(free_blocks_, upstream_block);
-    return first_fit(free_blocks_, size);
+    return best_fit(free_blocks_, size);
   }
 
   /**
-   * @brief Get the size to grow the global arena given the requested `size` bytes.
+   * @brief Get the size to grow the global arena given the requested `size` bytes, according to
+   * the growth policy.
    *
-   * This simply grows the global arena to the maximum size.
+   * @throws `std::bad_alloc` if growing by `size` bytes would exceed the maximum size.
    *
    * @param size The number of bytes required.
    * @return size The size for the arena to grow.
    */
-  constexpr std::size_t size_to_grow(std::size_t size) const
+  std::size_t size_to_grow(std::size_t size) const
+  {
+    auto const grow_size = growth_policy_.size_to_grow(size, current_size_, maximum_size_);
+    if (grow_size == 0) { RMM_FAIL("Maximum pool size exceeded", rmm::bad_alloc); }
+    return grow_size;
+  }
+
+  /**
+   * @brief Cache whole superblocks from the start of `b` until the cache is full.
+   *
+   * @param b The free block, which must lie within a single upstream allocation.
+   * @return block The rest of `b`, which may be invalid if all of it was cached.
+   */
+  block cache_superblocks(block b)
   {
-    if (current_size_ + size > maximum_size_) {
-      RMM_FAIL("Maximum pool size exceeded", rmm::bad_alloc);
+    while (b.size() >= superblock_size_ && superblock_cache_.insert(cached_superblock(b))) {
+      if (b.size() == superblock_size_) { return {}; }
+      b = block{static_cast<char*>(b.pointer()) + superblock_size_, b.size() - superblock_size_};
     }
-    return maximum_size_ - current_size_;
+    return b;
+  }
+
+  /**
+   * @brief Returns the pointer to cache for the superblock at the start of `b`.
+   *
+   * Superblocks are aligned to 256 bytes, so the lowest bit of the pointer is free to record
+   * whether the superblock is a head.
+   */
+  static void* cached_superblock(block const& b) noexcept
+  {
+    return static_cast<char*>(b.pointer()) + (b.is_head() ? 1 : 0);
+  }
+
+  /// Returns the superblock for a pointer taken from the superblock cache.
+  block uncached_superblock(void* p) const noexcept
+  {
+    auto const head = (reinterpret_cast<std::uintptr_t>(p) & 1U) != 0;
+    return block{static_cast<char*>(p) - (head ? 1 : 0), superblock_size_, head};
   }
 
   /**
@@ -392,7 +930,7 @@ class global_arena final {
    */
   block expand_arena(std::size_t size)
   {
-    upstream_blocks_.push_back({upstream_mr_->allocate(size), size});
+    upstream_blocks_.push_back({upstream_mr_->allocate(size), size, true});
     current_size_ += size;
     return upstream_blocks_.back();
   }
@@ -401,10 +939,16 @@ class global_arena final {
   Upstream* upstream_mr_;
   /// The maximum size the global arena can grow to.
   std::size_t maximum_size_;
+  /// The minimum size of the superblocks arenas allocate.
+  std::size_t superblock_size_;
+  /// Determines how much the global arena grows when it must.
+  growth_policy growth_policy_;
   /// The current size of the global arena.
   std::size_t current_size_{};
-  /// Address-ordered set of free blocks.
-  std::set<block> free_blocks_;
+  /// Free blocks, ordered by address and indexed by size.
+  free_block_set free_blocks_;
+  /// Free superblocks returned by arenas, not yet coalesced into the free blocks.
+  superblock_cache superblock_cache_;
   /// Blocks allocated from upstream so that they can be quickly freed.
   std::vector<block> upstream_blocks_;
   /// Mutex for exclusive lock.
@@ -419,16 +963,21 @@ class global_arena final {
  *
  * @tparam Upstream Memory resource to use for allocating the global arena. Implements
  * rmm::mr::device_memory_resource interface.
+ * @tparam StreamBackend The implementation of stream synchronization, e.g. `cuda_stream_backend`.
  */
-template <typename Upstream>
+template <typename Upstream, typename StreamBackend = cuda_stream_backend>
 class arena {
  public:
   /**
    * @brief Construct an `arena`.
    *
    * @param global_arena The global arena from which to allocate superblocks.
+   * @param owners The table in which to register the superblocks of this arena.
    */
-  explicit arena(global_arena<Upstream>& global_arena) : global_arena_{global_arena} {}
+  arena(global_arena<Upstream>& global_arena, superblock_owners<arena>& owners)
+    : global_arena_{global_arena}, owners_{owners}
+  {
+  }
 
   // Disable copy (and move) semantics.
   arena(const arena&) = delete;
@@ -445,6 +994,7 @@ class arena {
   void* allocate(std::size_t bytes)
   {
     lock_guard lock(mtx_);
+    free_remote_blocks();
     auto const b = get_block(bytes);
     allocated_blocks_.emplace(b.pointer(), b);
     return b.pointer();
@@ -462,6 +1012,7 @@ class arena {
   bool deallocate(void* p, std::size_t bytes, cuda_stream_view stream)
   {
     lock_guard lock(mtx_);
+    free_remote_blocks();
     auto const b = free_block(p, bytes);
     if (b.is_valid()) {
       auto const merged = coalesce_block(free_blocks_, b);
@@ -471,36 +1022,65 @@ class arena {
   }
 
   /**
-   * @brief Deallocate memory pointed to by `p`, keeping all free superblocks.
+   * @brief Queue memory pointed to by `p`, which another thread or stream is done with, to be
+   * freed by this arena.
    *
-   * This is done when deallocating from another arena. Since we don't have access to the CUDA
-   * stream associated with this arena, we don't coalesce the freed block and return it directly to
-   * the global arena.
+   * The memory is pushed onto a lock-free queue that the arena collects the next time it allocates
+   * or deallocates, so the caller never waits for the arena's lock unless the queue is full or the
+   * arena's thread has exited, in which case the caller collects the queue itself. The caller must
+   * synchronize the stream on which the memory was last used first.
    *
    * @param p Pointer to be deallocated.
    * @param bytes The size in bytes of the allocation. This must be equal to the value of `bytes`
    * that was passed to the `allocate` call that returned `p`.
-   * @return true if the allocation is found, false otherwise.
    */
-  bool deallocate(void* p, std::size_t bytes)
+  void deallocate_remote(void* p, std::size_t bytes)
+  {
+    if (!remote_frees_.push(block{p, bytes})) {
+      lock_guard lock(mtx_);
+      free_remote_blocks();
+      free_remote_block(block{p, bytes});
+      return;
+    }
+
+    // Pairs with the fence in clean(), so that either it pops the queued block or this sees that it
+    // has run. Release and acquire alone would let each side's store move after its next load.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (cleaned_.load()) {
+      lock_guard lock(mtx_);
+      free_remote_blocks();
+    }
+  }
+
+  /**
+   * @brief Free the blocks other threads or streams have queued for this arena, returning whole
+   * free superblocks to the global arena.
+   *
+   * This lets memory freed remotely be reused when the arena's own thread is idle.
+   */
+  void collect_remote_frees()
   {
     lock_guard lock(mtx_);
-    auto const b = free_block(p, bytes);
-    if (b.is_valid()) { global_arena_.deallocate(b); }
-    return b.is_valid();
+    free_remote_blocks();
   }
 
   /**
    * @brief Clean the arena and deallocate free blocks from the global arena.
    *
-   * This is only needed when a per-thread arena is about to die.
+   * This is only needed when a per-thread arena is about to die. Blocks the arena still has
+   * allocated are returned to the global arena as other threads free them.
    */
   void clean()
   {
     lock_guard lock(mtx_);
+    cleaned_ = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with deallocate_remote()
+    free_remote_blocks();
+    for (auto const& b : free_blocks_) {
+      owners_.erase(b);
+    }
     global_arena_.deallocate(free_blocks_);
     free_blocks_.clear();
-    allocated_blocks_.clear();
   }
 
  private:
@@ -514,16 +1094,16 @@ class arena {
    */
   block get_block(std::size_t size)
   {
-    if (size < minimum_superblock_size) {
-      // Find the first-fit free block.
-      auto const b = first_fit(free_blocks_, size);
+    if (size < global_arena_.superblock_size()) {
+      // Find the best-fit free block.
+      auto const b = best_fit(free_blocks_, size);
       if (b.is_valid()) { return b; }
     }
 
     // No existing larger blocks available, so grow the arena and obtain a superblock.
     auto const superblock = expand_arena(size);
     coalesce_block(free_blocks_, superblock);
-    return first_fit(free_blocks_, size);
+    return best_fit(free_blocks_, size);
   }
 
   /**
@@ -533,8 +1113,10 @@ class arena {
    */
   block expand_arena(std::size_t size)
   {
-    auto const superblock_size = std::max(size, minimum_superblock_size);
-    return global_arena_.allocate(superblock_size);
+    auto const superblock_size = std::max(size, global_arena_.superblock_size());
+    auto const superblock      = global_arena_.allocate(superblock_size);
+    owners_.insert(superblock, this);
+    return superblock;
   }
 
   /**
@@ -568,20 +1150,82 @@ class arena {
   void shrink_arena(block const& b, cuda_stream_view stream)
   {
     // Don't shrink if b is not a superblock.
-    if (!b.is_superblock()) return;
+    if (b.size() < global_arena_.superblock_size()) {
+      unsynchronized_frees_ = true;
+      return;
+    }
 
-    stream.synchronize_no_throw();
+    RMM_ASSERT_CUDA_SUCCESS(StreamBackend::synchronize_stream(stream.value()));
+    unsynchronized_frees_ = false;
+    release_superblock(b);
+  }
 
+  /**
+   * @brief Return the free superblock `b` to the global arena. The caller must hold the mutex.
+   *
+   * @param b The superblock, which must be in the free blocks and not in use on any stream.
+   */
+  void release_superblock(block const& b)
+  {
+    // Unregistered first, since the global arena may give the memory to another arena at once
+    owners_.erase(b);
     global_arena_.deallocate(b);
     free_blocks_.erase(b);
   }
 
+  /**
+   * @brief Free the blocks queued by `deallocate_remote`. The caller must hold the mutex.
+   */
+  void free_remote_blocks()
+  {
+    for (auto b = remote_frees_.pop(); b.is_valid(); b = remote_frees_.pop()) {
+      free_remote_block(b);
+    }
+  }
+
+  /**
+   * @brief Free block `b`, which another thread or stream is done with. The caller must hold the
+   * mutex.
+   *
+   * The remote thread synchronized its stream, so a whole free superblock is returned to the global
+   * arena without the arena's stream, unless the arena has freed memory on its stream since it last
+   * synchronized it. Once the arena has been cleaned, or if the block is not found, it is returned
+   * to the global arena directly.
+   *
+   * @param b The block to free.
+   */
+  void free_remote_block(block const& b)
+  {
+    auto const found = free_block(b.pointer(), b.size());
+    if (!found.is_valid()) {
+      global_arena_.deallocate(b);
+      return;
+    }
+    if (cleaned_) {
+      owners_.erase(found);
+      global_arena_.deallocate(found);
+      return;
+    }
+    auto const merged = coalesce_block(free_blocks_, found);
+    if (merged.size() >= global_arena_.superblock_size() && !unsynchronized_frees_) {
+      release_superblock(merged);
+    }
+  }
+
   /// The global arena to allocate superblocks from.
   global_arena<Upstream>& global_arena_;
-  /// Free blocks.
-  std::set<block> free_blocks_;
+  /// The table of superblock owners, shared by all arenas.
+  superblock_owners<arena>& owners_;
+  /// Free blocks, ordered by address and indexed by size.
+  free_block_set free_blocks_;
   //// Map of pointer address to allocated blocks.
   std::unordered_map<void*, block> allocated_blocks_;
+  /// Blocks freed by other threads or streams, not yet collected.
+  remote_free_queue remote_frees_;
+  /// Whether memory freed on the arena's stream may still be in use, until it is synchronized.
+  bool unsynchronized_frees_{false};
+  /// Whether the arena's thread has exited, after which the arena no longer collects remote frees.
+  std::atomic<bool> cleaned_{false};
   /// Mutex for exclusive lock.
   mutable std::mutex mtx_;
 };
@@ -593,11 +1237,12 @@ class arena {
  *
  * @tparam Upstream Memory resource to use for allocating the global arena. Implements
  * rmm::mr::device_memory_resource interface.
+ * @tparam StreamBackend The implementation of stream synchronization used by the arena.
  */
-template <typename Upstream>
+template <typename Upstream, typename StreamBackend = cuda_stream_backend>
 class arena_cleaner {
  public:
-  explicit arena_cleaner(std::shared_ptr<arena<Upstream>> const& a) : arena_(a) {}
+  explicit arena_cleaner(std::shared_ptr<arena<Upstream, StreamBackend>> const& a) : arena_(a) {}
 
   // Disable copy (and move) semantics.
   arena_cleaner(const arena_cleaner&) = delete;
@@ -613,7 +1258,7 @@ class arena_cleaner {
 
  private:
   /// A non-owning pointer to the arena that may need cleaning.
-  std::weak_ptr<arena<Upstream>> arena_;
+  std::weak_ptr<arena<Upstream, StreamBackend>> arena_;
 };
 
 }  // namespace arena
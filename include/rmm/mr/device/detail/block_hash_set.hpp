@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <rmm/detail/error.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief An open-addressing hash set of blocks, keyed by block pointer.
+ *
+ * Used to look up allocated blocks by pointer on deallocation. Lookup, insertion and erasure are
+ * expected O(1). Slots are stored in a single contiguous array that is only reallocated when the
+ * set grows beyond half of its capacity, so once the capacity has been reserved neither insertion
+ * nor erasure touch the host heap (unlike node-based containers such as `std::set`).
+ *
+ * Collisions are resolved by linear probing, and erasure uses backward-shift deletion, so there
+ * are no tombstones and probe sequences stay short under churn.
+ *
+ * @tparam BlockType The type of block to store. Must provide `pointer()` and `is_valid()`, and a
+ * default-constructed block must be invalid. Invalid (null) blocks cannot be stored.
+ */
+template <typename BlockType>
+class block_hash_set {
+ public:
+  using block_type = BlockType;
+
+  /// The default number of slots reserved on construction.
+  static constexpr std::size_t default_capacity = std::size_t{1} << 12;
+
+  /**
+   * @brief Forward iterator over the blocks in the set, in unspecified order.
+   */
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = block_type;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = block_type const*;
+    using reference         = block_type const&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return *slot_; }
+    pointer operator->() const { return slot_; }
+
+    const_iterator& operator++()
+    {
+      ++slot_;
+      skip_empty();
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      auto tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const_iterator const& other) const { return slot_ == other.slot_; }
+    bool operator!=(const_iterator const& other) const { return slot_ != other.slot_; }
+
+   private:
+    friend class block_hash_set;
+
+    const_iterator(pointer slot, pointer end) : slot_{slot}, end_{end} { skip_empty(); }
+
+    void skip_empty()
+    {
+      while (slot_ != end_ && not slot_->is_valid()) {
+        ++slot_;
+      }
+    }
+
+    pointer slot_{};
+    pointer end_{};
+  };
+
+  /**
+   * @brief Construct an empty set with room for `capacity / 2` blocks before it must grow.
+   *
+   * @param capacity The initial number of slots. Rounded up to a power of two.
+   */
+  explicit block_hash_set(std::size_t capacity = default_capacity) { rehash(capacity); }
+
+  const_iterator begin() const noexcept { return {slots_.data(), slots_.data() + slots_.size()}; }
+  const_iterator end() const noexcept
+  {
+    return {slots_.data() + slots_.size(), slots_.data() + slots_.size()};
+  }
+
+  /// Returns the number of blocks in the set.
+  std::size_t size() const noexcept { return size_; }
+
+  /// Returns true if the set contains no blocks.
+  bool empty() const noexcept { return size_ == 0; }
+
+  /// Returns the number of slots, which is twice the number of blocks the set can hold before
+  /// growing.
+  std::size_t capacity() const noexcept { return slots_.size(); }
+
+  /**
+   * @brief Ensure that `n` blocks can be stored without further host allocation.
+   *
+   * @param n The number of blocks to make room for.
+   */
+  void reserve(std::size_t n)
+  {
+    if (2 * n > capacity()) { rehash(2 * n); }
+  }
+
+  /**
+   * @brief Inserts block `b`, which must be valid and whose pointer must not already be in the set.
+   *
+   * @param b The block to insert.
+   */
+  void insert(block_type const& b)
+  {
+    RMM_LOGGING_ASSERT(b.is_valid());
+    if (2 * (size_ + 1) > capacity()) { rehash(2 * capacity()); }
+    auto i = home(key(b.pointer()));
+    while (slots_[i].is_valid()) {
+      RMM_LOGGING_ASSERT(key(slots_[i].pointer()) != key(b.pointer()));
+      i = (i + 1) & mask_;
+    }
+    slots_[i] = b;
+    ++size_;
+  }
+
+  /**
+   * @brief Finds the block whose pointer is `p`.
+   *
+   * @param p The pointer to look up.
+   * @return An iterator to the block, or `end()` if there is no block with pointer `p`.
+   */
+  const_iterator find(void const* p) const noexcept
+  {
+    auto const k = key(p);
+    for (auto i = home(k); slots_[i].is_valid(); i = (i + 1) & mask_) {
+      if (key(slots_[i].pointer()) == k) { return {&slots_[i], slots_.data() + slots_.size()}; }
+    }
+    return end();
+  }
+
+  /**
+   * @brief Removes the block referred to by `iter` from the set.
+   *
+   * Invalidates all iterators.
+   *
+   * @param iter An iterator to the block to erase. Must not be `end()`.
+   */
+  void erase(const_iterator iter) noexcept
+  {
+    // Backward-shift deletion: move later entries of the probe sequence into the hole until an
+    // empty slot or an entry already at its home slot is reached.
+    auto hole = static_cast<std::size_t>(iter.slot_ - slots_.data());
+    for (auto i = (hole + 1) & mask_; slots_[i].is_valid(); i = (i + 1) & mask_) {
+      auto const h = home(key(slots_[i].pointer()));
+      // Move entry i into the hole unless its home slot lies cyclically within (hole, i]
+      if (((i - h) & mask_) >= ((i - hole) & mask_)) {
+        slots_[hole] = slots_[i];
+        hole         = i;
+      }
+    }
+    slots_[hole] = block_type{};
+    --size_;
+  }
+
+  /// Removes all blocks from the set, keeping its capacity.
+  void clear() noexcept
+  {
+    std::fill(slots_.begin(), slots_.end(), block_type{});
+    size_ = 0;
+  }
+
+ private:
+  static std::uintptr_t key(void const* p) noexcept { return reinterpret_cast<std::uintptr_t>(p); }
+
+  std::size_t home(std::uintptr_t k) const noexcept
+  {
+    // Fibonacci hashing. Block pointers are aligned, so the low bits carry no information.
+    constexpr std::uint64_t multiplier{0x9E3779B97F4A7C15};
+    return static_cast<std::size_t>(((static_cast<std::uint64_t>(k) >> 8) * multiplier) >> shift_);
+  }
+
+  void rehash(std::size_t capacity)
+  {
+    std::size_t log2_capacity{4};  // at least 16 slots
+    while ((std::size_t{1} << log2_capacity) < capacity) {
+      ++log2_capacity;
+    }
+
+    std::vector<block_type> old_slots(std::size_t{1} << log2_capacity);
+    std::swap(slots_, old_slots);
+    mask_  = slots_.size() - 1;
+    shift_ = 64 - log2_capacity;
+    size_  = 0;
+
+    for (auto const& b : old_slots) {
+      if (b.is_valid()) { insert(b); }
+    }
+  }
+
+  std::vector<block_type> slots_;  // invalid (default-constructed) blocks mark empty slots
+  std::size_t size_{};             // number of blocks in the set
+  std::size_t mask_{};             // slots_.size() - 1
+  std::size_t shift_{};            // 64 - log2(slots_.size())
+};
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
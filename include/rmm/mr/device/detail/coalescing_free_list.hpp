@@ -21,7 +21,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
 #include <list>
 
 namespace rmm {
@@ -173,45 +175,38 @@ struct coalescing_free_list : free_list<block> {
    */
   void insert(block_type const& b)
   {
-    if (is_empty()) {
-      free_list::insert(cend(), b);
-      return;
-    }
-
     // Find the right place (in ascending ptr order) to insert the block
     // Can't use binary_search because it's a linked list and will be quadratic
-    auto const next     = std::find_if(begin(), end(), [b](block_type const& i) { return b < i; });
-    auto const previous = (next == cbegin()) ? next : std::prev(next);
-
-    // Coalesce with neighboring blocks or insert the new block if it can't be coalesced
-    bool const merge_prev = previous->is_contiguous_before(b);
-    bool const merge_next = (next != cend()) && b.is_contiguous_before(*next);
-
-    if (merge_prev && merge_next) {
-      *previous = previous->merge(b).merge(*next);
-      erase(next);
-    } else if (merge_prev) {
-      *previous = previous->merge(b);
-    } else if (merge_next) {
-      *next = b.merge(*next);
-    } else {
-      free_list::insert(next, b);  // cannot be coalesced, just insert
-    }
+    auto const next = std::find_if(begin(), end(), [b](block_type const& i) { return b < i; });
+    insert_before(next, b);
   }
 
   /**
-   * @brief Moves blocks from range `[first, last)` into the free_list in their correct order,
+   * @brief Moves blocks from free_list `other` into this free_list in their correct order,
    *        coalescing them with their preceding and following blocks if they are contiguous.
    *
-   * @tparam InputIt iterator type
-   * @param first The beginning of the range of blocks to insert
-   * @param last The end of the range of blocks to insert.
+   * @param other The free_list to insert into this one.
+   */
+  void insert(free_list&& other) { merge(std::move(other)); }
+
+  /**
+   * @brief Merges the address-ordered free_list `other` into this one, coalescing contiguous
+   *        blocks.
+   *
+   * Both lists are walked once, so this takes O(n + m) time for lists of n and m blocks, where
+   * inserting the blocks of `other` one at a time takes O(n * m).
+   *
+   * @param other The free_list to merge into this one. It is left empty.
    */
-  void insert(free_list&& other)
+  void merge(free_list&& other)
   {
-    std::for_each(std::make_move_iterator(other.begin()),
-                  std::make_move_iterator(other.end()),
-                  [this](block_type&& b) { this->insert(std::move(b)); });
+    // The blocks of `other` are in ascending ptr order, so each is inserted after the previous one
+    auto next = begin();
+    std::for_each(other.cbegin(), other.cend(), [this, &next](block_type const& b) {
+      next = std::find_if(next, end(), [b](block_type const& i) { return b < i; });
+      next = std::next(insert_before(next, b));
+    });
+    other.clear();
   }
 
   /**
@@ -240,6 +235,86 @@ struct coalescing_free_list : free_list<block> {
     return block_type{};  // not found
   }
 
+  /**
+   * @brief Finds the block with the lowest address in the `free_list` large enough to fit `size`
+   * bytes.
+   *
+   * This is an address-ordered "first fit" search.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_lowest_block(size_t size)
+  {
+    auto const iter =
+      std::find_if(cbegin(), cend(), [size](block_type const& b) { return b.fits(size); });
+
+    if (iter != cend()) {
+      block_type const found = *iter;
+      erase(iter);
+      return found;
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Finds the block with the highest address in the `free_list` large enough to fit `size`
+   * bytes.
+   *
+   * This is an address-ordered "last fit" search.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_highest_block(size_t size)
+  {
+    auto const& blocks = get_list();
+    auto const fits    = [size](block_type const& b) { return b.fits(size); };
+    auto const iter    = std::find_if(blocks.crbegin(), blocks.crend(), fits);
+
+    if (iter != blocks.crend()) {
+      block_type const found = *iter;
+      erase(std::next(iter).base());
+      return found;
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Returns the size of the largest block in the free list, or 0 if it is empty.
+   *
+   * The size is maintained as blocks are inserted and erased, so this takes constant time.
+   *
+   * @return std::size_t The size in bytes of the largest block.
+   */
+  std::size_t largest_block_size() const noexcept { return largest_; }
+
+  /**
+   * @brief Removes the block indicated by `iter` from the free list.
+   *
+   * Takes O(n) time in the number of blocks if the block is the largest, to find the next
+   * largest, and constant time otherwise.
+   *
+   * @param iter An iterator referring to the block to erase.
+   */
+  void erase(const_iterator iter)
+  {
+    auto const erased_size = iter->size();
+    free_list::erase(iter);
+    if (erased_size == largest_) { update_largest(); }
+  }
+
+  /**
+   * @brief Erase all blocks from the free_list.
+   */
+  void clear() noexcept
+  {
+    largest_ = 0;
+    free_list::clear();
+  }
+
   /**
    * @brief Print all blocks in the free_list.
    */
@@ -248,6 +323,56 @@ struct coalescing_free_list : free_list<block> {
     std::cout << size() << '\n';
     std::for_each(cbegin(), cend(), [](auto const iter) { iter.print(); });
   }
+
+ private:
+  /**
+   * @brief Inserts block `b` before `next`, the first block after it, coalescing it with the
+   *        preceding and following blocks if either is contiguous.
+   *
+   * @param next Iterator to the first block with a higher address than `b`, or end().
+   * @param b The block to insert.
+   * @return iterator The block that now contains `b`.
+   */
+  iterator insert_before(iterator next, block_type const& b)
+  {
+    auto const previous = (next == begin()) ? end() : std::prev(next);
+
+    // Coalesce with neighboring blocks or insert the new block if it can't be coalesced
+    bool const merge_prev = (previous != end()) && previous->is_contiguous_before(b);
+    bool const merge_next = (next != end()) && b.is_contiguous_before(*next);
+
+    // The merged block is larger than the blocks it absorbs, so it is the only size to check
+    auto const inserted = [&]() {
+      if (merge_prev && merge_next) {
+        *previous = previous->merge(b).merge(*next);
+        free_list::erase(next);
+        return previous;
+      }
+      if (merge_prev) {
+        *previous = previous->merge(b);
+        return previous;
+      }
+      if (merge_next) {
+        *next = b.merge(*next);
+        return next;
+      }
+      free_list::insert(next, b);  // cannot be coalesced, just insert
+      return std::prev(next);
+    }();
+    largest_ = std::max(largest_, inserted->size());
+    return inserted;
+  }
+
+  /// Finds the largest block by visiting every block.
+  void update_largest() noexcept
+  {
+    largest_ = 0;
+    std::for_each(cbegin(), cend(), [this](block_type const& b) {
+      largest_ = std::max(largest_, b.size());
+    });
+  }
+
+  std::size_t largest_{};  // size of the largest block, or 0 if the list is empty
 };  // coalescing_free_list
 
 }  // namespace detail
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cuda_runtime_api.h>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief The event and stream operations used by the stream-ordered memory resources to order
+ * reuse of memory across streams, implemented with the CUDA runtime.
+ *
+ * Any type with the same static member functions can be used instead, e.g.
+ * `host_stream_backend`, which simulates streams and events on the host so that the
+ * stream-ordering logic can be tested and benchmarked without a device. Errors are returned rather
+ * than thrown so that callers can choose between `RMM_CUDA_TRY` and `RMM_ASSERT_CUDA_SUCCESS`.
+ */
+struct cuda_stream_backend {
+  /// Creates an event without timing, which is all that is needed for synchronization.
+  static cudaError_t create_event(cudaEvent_t* event)
+  {
+    return cudaEventCreateWithFlags(event, cudaEventDisableTiming);
+  }
+
+  static cudaError_t destroy_event(cudaEvent_t event) { return cudaEventDestroy(event); }
+
+  /// Records `event` after the work currently enqueued on `stream`.
+  static cudaError_t record_event(cudaEvent_t event, cudaStream_t stream)
+  {
+    return cudaEventRecord(event, stream);
+  }
+
+  /// Makes work subsequently enqueued on `stream` wait until `event` has completed.
+  static cudaError_t stream_wait_event(cudaStream_t stream, cudaEvent_t event)
+  {
+    return cudaStreamWaitEvent(stream, event, 0);
+  }
+
+  /// Returns `cudaSuccess` if `event` has completed, else `cudaErrorNotReady`. Does not block.
+  static cudaError_t query_event(cudaEvent_t event) { return cudaEventQuery(event); }
+
+  /// Blocks the calling thread until `event` has completed.
+  static cudaError_t synchronize_event(cudaEvent_t event) { return cudaEventSynchronize(event); }
+
+  /// Blocks the calling thread until all work enqueued on `stream` has completed.
+  static cudaError_t synchronize_stream(cudaStream_t stream)
+  {
+    return cudaStreamSynchronize(stream);
+  }
+};
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
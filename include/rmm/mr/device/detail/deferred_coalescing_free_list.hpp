@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief A coalescing free list that defers coalescing of recently freed blocks, like the
+ * unsorted bin of dlmalloc.
+ *
+ * Inserted blocks are first kept in a small unsorted bin. `get_block` checks the bin before the
+ * underlying free list, and takes a block from it if the block fits exactly or wastes at most
+ * 1/8 of the requested size. Only when the bin has no such block, or when it is full, are its
+ * blocks inserted (and coalesced) into the underlying free list. Alternating allocations and
+ * deallocations of the same size thus reuse the same block without coalescing it with its
+ * neighbors, only to split it again.
+ *
+ * Iterating over the free list through a non-const reference first coalesces the bin, so that
+ * every free block is visited. Iterators, `erase` and const iteration refer to the underlying free
+ * list only.
+ *
+ * @tparam FreeList The underlying coalescing free list, e.g. `coalescing_free_list` (the default)
+ * or `indexed_free_list`.
+ * @tparam UnsortedBinSize The maximum number of blocks in the unsorted bin.
+ */
+template <typename FreeList = coalescing_free_list, std::size_t UnsortedBinSize = 16>
+struct deferred_coalescing_free_list : FreeList {
+  using block_type     = typename FreeList::block_type;
+  using size_type      = typename FreeList::size_type;
+  using iterator       = typename FreeList::iterator;
+  using const_iterator = typename FreeList::const_iterator;
+
+  deferred_coalescing_free_list()  = default;
+  ~deferred_coalescing_free_list() = default;
+
+  /**
+   * @brief Inserts a block into the unsorted bin, first coalescing the bin into the underlying
+   * free list if it is full.
+   *
+   * @param b The block to insert.
+   */
+  void insert(block_type const& b)
+  {
+    if (unsorted_.size() == UnsortedBinSize) { coalesce(); }
+    unsorted_.push_back(b);
+    unsorted_largest_ = std::max(unsorted_largest_, b.size());
+  }
+
+  /**
+   * @brief Moves blocks from free_list `other` into this free_list, coalescing them with their
+   *        preceding and following blocks if they are contiguous.
+   *
+   * Both unsorted bins are coalesced first.
+   *
+   * @param other The free_list to insert into this one.
+   */
+  void insert(deferred_coalescing_free_list&& other)
+  {
+    coalesce();
+    other.coalesce();
+    FreeList::insert(std::move(static_cast<FreeList&>(other)));
+  }
+
+  /**
+   * @brief Finds a block in the `free_list` large enough to fit `size` bytes.
+   *
+   * An exact or near fit in the unsorted bin is preferred, the most recently inserted first.
+   * Otherwise the bin is coalesced and the underlying free list is searched.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_block(std::size_t size)
+  {
+    auto best = unsorted_.rend();
+    for (auto iter = unsorted_.rbegin(); iter != unsorted_.rend(); ++iter) {
+      if (is_near_fit(*iter, size) && (best == unsorted_.rend() || iter->size() < best->size())) {
+        best = iter;
+        if (best->size() == size) { break; }
+      }
+    }
+
+    if (best != unsorted_.rend()) {
+      block_type const found = *best;
+      *best                  = unsorted_.back();
+      unsorted_.pop_back();
+      if (found.size() == unsorted_largest_) { update_unsorted_largest(); }
+      return found;
+    }
+
+    coalesce();
+    return FreeList::get_block(size);
+  }
+
+  /**
+   * @brief Finds the block with the lowest address large enough to fit `size` bytes, after
+   * coalescing the unsorted bin.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_lowest_block(std::size_t size)
+  {
+    coalesce();
+    return FreeList::get_lowest_block(size);
+  }
+
+  /**
+   * @brief Finds the block with the highest address large enough to fit `size` bytes, after
+   * coalescing the unsorted bin.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_highest_block(std::size_t size)
+  {
+    coalesce();
+    return FreeList::get_highest_block(size);
+  }
+
+  /**
+   * @brief Inserts all blocks of the unsorted bin into the underlying free list, coalescing them.
+   */
+  void coalesce()
+  {
+    if (unsorted_.empty()) { return; }
+
+    // The bin's blocks are coalesced with each other in a temporary list, inserted in descending
+    // ptr order, and that list is then inserted into the underlying one through its
+    // insert(FreeList&&). Only coalescing_free_list takes advantage of the order: each block goes
+    // to the front of the temporary list, which is merged in one pass. Other free lists insert the
+    // blocks one at a time.
+    std::sort(unsorted_.begin(), unsorted_.end());
+    FreeList sorted{};
+    std::for_each(unsorted_.rbegin(), unsorted_.rend(), [&sorted](block_type const& b) {
+      sorted.insert(b);
+    });
+    unsorted_.clear();
+    unsorted_largest_ = 0;
+    FreeList::insert(std::move(sorted));
+  }
+
+  /// Beginning of the free list, after coalescing the unsorted bin
+  iterator begin()
+  {
+    coalesce();
+    return FreeList::begin();
+  }
+
+  /// Beginning of the free list, after coalescing the unsorted bin
+  const_iterator cbegin()
+  {
+    coalesce();
+    return FreeList::cbegin();
+  }
+
+  using FreeList::begin;
+  using FreeList::cbegin;
+
+  /**
+   * @brief The size of the free list in blocks, including those in the unsorted bin.
+   *
+   * @return size_type The number of blocks in the free list.
+   */
+  size_type size() const noexcept { return FreeList::size() + unsorted_.size(); }
+
+  /**
+   * @brief checks whether the free_list is empty.
+   *
+   * @return true If there are no blocks in the free_list or the unsorted bin.
+   */
+  bool is_empty() const noexcept { return FreeList::is_empty() && unsorted_.empty(); }
+
+  /**
+   * @brief Erase all blocks from the free_list and the unsorted bin.
+   */
+  void clear() noexcept
+  {
+    FreeList::clear();
+    unsorted_.clear();
+    unsorted_largest_ = 0;
+  }
+
+  /**
+   * @brief Returns the size of the largest block in the free list, or 0 if it is empty.
+   *
+   * The largest size in the unsorted bin is maintained as blocks enter and leave it, so this takes
+   * as long as `largest_block_size()` of the underlying free list.
+   *
+   * @return std::size_t The size in bytes of the largest block.
+   */
+  std::size_t largest_block_size() const noexcept
+  {
+    return std::max(FreeList::largest_block_size(), unsorted_largest_);
+  }
+
+  /**
+   * @brief Print all blocks in the free_list and the unsorted bin.
+   */
+  void print() const
+  {
+    FreeList::print();
+    std::cout << "unsorted: " << unsorted_.size() << '\n';
+    std::for_each(unsorted_.cbegin(), unsorted_.cend(), [](auto const& b) { b.print(); });
+  }
+
+ private:
+  /// Returns true if `b` fits `size` bytes and wastes at most 1/8 of `size`.
+  static bool is_near_fit(block_type const& b, std::size_t size) noexcept
+  {
+    return b.fits(size) && b.size() - size <= size / 8;
+  }
+
+  /// Finds the largest block in the unsorted bin.
+  void update_unsorted_largest() noexcept
+  {
+    unsorted_largest_ = 0;
+    std::for_each(unsorted_.cbegin(), unsorted_.cend(), [this](block_type const& b) {
+      unsorted_largest_ = std::max(unsorted_largest_, b.size());
+    });
+  }
+
+  std::vector<block_type> unsorted_;  // recently inserted blocks, not yet coalesced
+  std::size_t unsorted_largest_{};    // size of the largest block in unsorted_, or 0
+};  // deferred_coalescing_free_list
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
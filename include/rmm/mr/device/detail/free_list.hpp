@@ -156,6 +156,14 @@ class free_list {
    */
   void pop_front() { blocks.pop_front(); }
 
+  /**
+   * @brief Returns the internal container of blocks, for derived free lists that need operations
+   * specific to `list_type` (e.g. `lower_bound` on an ordered container).
+   *
+   * @return list_type& The internal container of blocks.
+   */
+  list_type& get_list() noexcept { return blocks; }
+
  private:
   list_type blocks;  // The internal container of blocks
 };
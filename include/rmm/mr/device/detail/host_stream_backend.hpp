@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cuda_runtime_api.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief A stream simulated on the host: an in-order queue of work executed by a worker thread.
+ *
+ * Each item of work enqueued is given a ticket, its position in the queue. Progress is tracked by
+ * the number of items completed, so work with ticket `t` has completed once `t` items have.
+ */
+class simulated_stream {
+ public:
+  simulated_stream() : worker_{[this]() { run(); }} {}
+
+  ~simulated_stream()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+  }
+
+  simulated_stream(simulated_stream const&) = delete;
+  simulated_stream& operator=(simulated_stream const&) = delete;
+
+  /**
+   * @brief Enqueue `work` to be executed after all work previously enqueued.
+   *
+   * @return std::uint64_t The ticket of `work`.
+   */
+  std::uint64_t enqueue(std::function<void()> work)
+  {
+    std::uint64_t ticket{};
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      queue_.push_back(std::move(work));
+      ticket = ++enqueued_;
+    }
+    cv_.notify_all();
+    return ticket;
+  }
+
+  /// Returns the ticket of the most recently enqueued work, or 0 if none has been enqueued.
+  std::uint64_t last_ticket() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return enqueued_;
+  }
+
+  /// Blocks until the work with ticket `ticket` (and so all work before it) has completed.
+  void wait_for(std::uint64_t ticket) const
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this, ticket]() { return completed_ >= ticket; });
+  }
+
+  /// Returns true if the work with ticket `ticket` has completed.
+  bool is_complete(std::uint64_t ticket) const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return completed_ >= ticket;
+  }
+
+ private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+      cv_.wait(lock, [this]() { return stop_ || not queue_.empty(); });
+      if (queue_.empty()) { return; }  // stopped, and all work has completed
+      auto work = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      work();
+      lock.lock();
+      ++completed_;
+      cv_.notify_all();
+    }
+  }
+
+  mutable std::mutex mtx_;
+  mutable std::condition_variable cv_;       // signals new work, completed work and stopping
+  std::deque<std::function<void()>> queue_;  // work not yet started
+  std::uint64_t enqueued_{};                 // number of items of work enqueued
+  std::uint64_t completed_{};                // number of items of work completed
+  bool stop_{false};
+  std::thread worker_;  // declared last so that it starts after the other members are initialized
+};
+
+/**
+ * @brief An event simulated on the host: a ticket on a simulated stream.
+ *
+ * An event that has never been recorded is complete.
+ */
+struct simulated_event {
+  simulated_stream* stream{};  // the stream on which the event was last recorded
+  std::uint64_t ticket{};      // the ticket of the last work enqueued before it was recorded
+};
+
+/**
+ * @brief Implements the operations of `cuda_stream_backend` with streams and events simulated on
+ * the host, so that the stream-ordered memory resources can run multi-stream workloads without a
+ * device.
+ *
+ * Stream handles are not interpreted: each distinct `cudaStream_t` value (including the default
+ * stream handles) names its own simulated stream, which is created on first use and runs until the
+ * program exits. There is no implicit synchronization with the default stream. Work, e.g. a
+ * simulated kernel, can be added to a stream with `enqueue()`.
+ *
+ * Event handles are pointers to `simulated_event`, so they must only be passed to this backend.
+ */
+struct host_stream_backend {
+  /**
+   * @brief Enqueue `work` on the simulated stream `stream`.
+   *
+   * @param stream The stream on which to execute `work`.
+   * @param work The work to execute, in order with all other work on `stream`.
+   */
+  static void enqueue(cudaStream_t stream, std::function<void()> work)
+  {
+    get_stream(stream).enqueue(std::move(work));
+  }
+
+  static cudaError_t create_event(cudaEvent_t* event)
+  {
+    *event = reinterpret_cast<cudaEvent_t>(new simulated_event{});
+    return cudaSuccess;
+  }
+
+  static cudaError_t destroy_event(cudaEvent_t event)
+  {
+    delete as_simulated(event);
+    return cudaSuccess;
+  }
+
+  static cudaError_t record_event(cudaEvent_t event, cudaStream_t stream)
+  {
+    auto& s = get_stream(stream);
+    std::lock_guard<std::mutex> lock(events_mutex());
+    *as_simulated(event) = simulated_event{&s, s.last_ticket()};
+    return cudaSuccess;
+  }
+
+  static cudaError_t stream_wait_event(cudaStream_t stream, cudaEvent_t event)
+  {
+    // As with CUDA, the wait is for the event as last recorded when the wait is enqueued
+    auto const recorded = load(event);
+    if (recorded.stream != nullptr && not recorded.stream->is_complete(recorded.ticket)) {
+      get_stream(stream).enqueue([recorded]() { recorded.stream->wait_for(recorded.ticket); });
+    }
+    return cudaSuccess;
+  }
+
+  static cudaError_t query_event(cudaEvent_t event)
+  {
+    auto const recorded = load(event);
+    return (recorded.stream == nullptr || recorded.stream->is_complete(recorded.ticket))
+             ? cudaSuccess
+             : cudaErrorNotReady;
+  }
+
+  static cudaError_t synchronize_event(cudaEvent_t event)
+  {
+    auto const recorded = load(event);
+    if (recorded.stream != nullptr) { recorded.stream->wait_for(recorded.ticket); }
+    return cudaSuccess;
+  }
+
+  static cudaError_t synchronize_stream(cudaStream_t stream)
+  {
+    auto& s = get_stream(stream);
+    s.wait_for(s.last_ticket());
+    return cudaSuccess;
+  }
+
+ private:
+  static simulated_event* as_simulated(cudaEvent_t event)
+  {
+    return reinterpret_cast<simulated_event*>(event);
+  }
+
+  // Events may be recorded and waited on concurrently from different threads
+  static std::mutex& events_mutex()
+  {
+    static std::mutex mtx;
+    return mtx;
+  }
+
+  static simulated_event load(cudaEvent_t event)
+  {
+    std::lock_guard<std::mutex> lock(events_mutex());
+    return *as_simulated(event);
+  }
+
+  static simulated_stream& get_stream(cudaStream_t stream)
+  {
+    struct stream_map {
+      // Work on one stream may wait on another, so all streams finish before any is destroyed
+      ~stream_map()
+      {
+        for (auto const& s : streams) {
+          s.second->wait_for(s.second->last_ticket());
+        }
+      }
+      std::mutex mtx;
+      std::unordered_map<cudaStream_t, std::unique_ptr<simulated_stream>> streams;
+    };
+    static stream_map map;
+
+    std::lock_guard<std::mutex> lock(map.mtx);
+    auto& s = map.streams[stream];
+    if (not s) { s = std::make_unique<simulated_stream>(); }
+    return *s;
+  }
+};
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
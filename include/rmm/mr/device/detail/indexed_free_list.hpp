@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/free_list.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <set>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief Comparator for block types that orders by size, then by pointer address.
+ *
+ * Ordering equal-sized blocks by address makes the best-fit search deterministic: of all the
+ * smallest blocks that fit, the one with the lowest address is chosen.
+ */
+template <typename block_type>
+struct compare_block_sizes {
+  bool operator()(block_type const& lhs, block_type const& rhs) const
+  {
+    return (lhs.size() < rhs.size()) || (lhs.size() == rhs.size() && lhs < rhs);
+  }
+};
+
+/**
+ * @brief An address-ordered free list of memory blocks that coalesces contiguous blocks on
+ * insertion and is additionally indexed by block size.
+ *
+ * The blocks are stored in two ordered sets: one ordered by address, used to find the neighbors
+ * of an inserted block for coalescing, and one ordered by size, used for best-fit search. This
+ * makes both `insert` and `get_block` O(log n) in the number of free blocks, where
+ * `coalescing_free_list` is O(n) for both.
+ */
+struct indexed_free_list : free_list<block, std::set<block, compare_blocks<block>>> {
+  indexed_free_list()  = default;
+  ~indexed_free_list() = default;
+
+  /**
+   * @brief Inserts a block into the `free_list` in the correct order, coalescing it with the
+   *        preceding and following blocks if either is contiguous.
+   *
+   * @param b The block to insert.
+   */
+  void insert(block_type const& b)
+  {
+    auto const next     = get_list().lower_bound(b.pointer());
+    auto const previous = (next == cbegin()) ? cend() : std::prev(next);
+
+    // Coalesce with neighboring blocks
+    bool const merge_prev = (previous != cend()) && previous->is_contiguous_before(b);
+    bool const merge_next = (next != cend()) && b.is_contiguous_before(*next);
+
+    block_type merged = b;
+    if (merge_next) {
+      merged = merged.merge(*next);
+      erase(next);
+    }
+    if (merge_prev) {
+      merged = previous->merge(merged);
+      erase(previous);
+    }
+
+    get_list().insert(merged);
+    size_index_.insert(merged);
+  }
+
+  /**
+   * @brief Moves blocks from free_list `other` into this free_list in their correct order,
+   *        coalescing them with their preceding and following blocks if they are contiguous.
+   *
+   * @param other The free_list to insert into this one.
+   */
+  void insert(indexed_free_list&& other)
+  {
+    std::for_each(other.cbegin(), other.cend(), [this](block_type const& b) { this->insert(b); });
+    other.clear();
+  }
+
+  /**
+   * @brief Finds the smallest block in the `free_list` large enough to fit `size` bytes.
+   *
+   * This is a "best fit" search in O(log n) time.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_block(size_t size)
+  {
+    auto const iter = size_index_.lower_bound(block_type{nullptr, size, false});
+
+    if (iter != size_index_.cend()) {
+      // Remove the block from the free_list and return it.
+      block_type const found = *iter;
+      size_index_.erase(iter);
+      get_list().erase(found);
+      return found;
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Finds the block with the lowest address in the `free_list` large enough to fit `size`
+   * bytes.
+   *
+   * This is an address-ordered "first fit" search in O(n) time.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_lowest_block(size_t size)
+  {
+    auto const iter =
+      std::find_if(cbegin(), cend(), [size](block_type const& b) { return b.fits(size); });
+
+    if (iter != cend()) {
+      block_type const found = *iter;
+      erase(iter);
+      return found;
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Finds the block with the highest address in the `free_list` large enough to fit `size`
+   * bytes.
+   *
+   * This is an address-ordered "last fit" search in O(n) time.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_highest_block(size_t size)
+  {
+    auto const& blocks = get_list();
+    auto const fits    = [size](block_type const& b) { return b.fits(size); };
+    auto const iter    = std::find_if(blocks.crbegin(), blocks.crend(), fits);
+
+    if (iter != blocks.crend()) {
+      block_type const found = *iter;
+      erase(std::next(iter).base());
+      return found;
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Returns the size of the largest block in the free list, or 0 if it is empty.
+   *
+   * This takes O(1) time.
+   *
+   * @return std::size_t The size in bytes of the largest block.
+   */
+  std::size_t largest_block_size() const noexcept
+  {
+    return size_index_.empty() ? 0 : size_index_.crbegin()->size();
+  }
+
+  /**
+   * @brief Removes the block indicated by `iter` from the free list.
+   *
+   * @param iter An iterator referring to the block to erase.
+   */
+  void erase(const_iterator iter)
+  {
+    size_index_.erase(*iter);
+    free_list::erase(iter);
+  }
+
+  /**
+   * @brief Erase all blocks from the free_list.
+   */
+  void clear() noexcept
+  {
+    size_index_.clear();
+    free_list::clear();
+  }
+
+  /**
+   * @brief Print all blocks in the free_list.
+   */
+  void print() const
+  {
+    std::cout << size() << '\n';
+    std::for_each(cbegin(), cend(), [](auto const iter) { iter.print(); });
+  }
+
+ private:
+  std::set<block_type, compare_block_sizes<block_type>> size_index_;  // blocks ordered by size
+};  // indexed_free_list
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
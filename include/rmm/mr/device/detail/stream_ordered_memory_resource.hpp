@@ -16,18 +16,27 @@
 #pragma once
 
 #include <limits>
+#include <rmm/cuda_stream.hpp>
 #include <rmm/detail/error.hpp>
 #include <rmm/logger.hpp>
+#include <rmm/mr/device/detail/cuda_stream_backend.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 
 #include <cuda_runtime_api.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <numeric>
 #include <set>
+#include <shared_mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace rmm {
 namespace mr {
@@ -63,34 +72,334 @@ struct crtp {
  * structures for allocated blocks and has functions to allocate and free blocks and to expand the
  * pool.
  *
- * Classes derived from stream_ordered_memory_resource must implement the following four methods,
+ * Each stream's free list has its own mutex, so threads allocating and deallocating on different
+ * streams do not contend as long as their own free lists can satisfy their requests. The map
+ * from streams to free lists is guarded by a reader-writer lock that is only taken exclusively
+ * when a stream is first seen. The global mutex (`get_mutex()`) is only taken to steal blocks
+ * from other streams, to merge free lists, and to expand the pool. Locks are always acquired in
+ * the order: global mutex, stream map lock, free list mutex, summary mutex. Only the holder of
+ * the global mutex may hold more than one free list mutex at a time.
+ *
+ * The size of the largest block in each stream's free list is kept in a max-heap (the "summary"),
+ * so that when a stream's own free list cannot satisfy a request, a stream that can is found in
+ * constant time rather than by searching every other free list.
+ *
+ * Classes derived from stream_ordered_memory_resource must implement the following five methods,
  * documented separately:
  *
  * 1. `size_t get_maximum_allocation_size() const`
  * 2. `block_type expand_pool(size_t size, free_list& blocks, cuda_stream_view stream)`
  * 3. `split_block allocate_from_block(block_type const& b, size_t size)`
  * 4. `block_type free_block(void* p, size_t size) noexcept`
+ * 5. `std::pair<std::size_t, std::size_t> free_summary() const`
+ *
+ * and may override `std::size_t largest_block_size(free_list const& blocks) const` and
+ * `block_type get_block_from_list(free_list& blocks, size_t size)`.
+ *
+ * Each stream has an event that is recorded after blocks are freed on the stream, and that a
+ * different stream must wait on before reusing those blocks. By default the event is recorded on
+ * every deallocation. Since recording an event is expensive relative to returning a block to a
+ * free list, `set_event_record_interval()` can instead defer recording until a number of blocks
+ * have been freed, or until another stream takes blocks from the stream's free list. Each free
+ * list counts the changes to it not yet covered by its event (its epoch), and the event is always
+ * recorded before another stream waits on it if there are any.
+ *
+ * Streams that are used interchangeably, e.g. a set of streams over which work is distributed
+ * round-robin, can be registered as a group with `add_stream_group()`, so that they share a single
+ * free list rather than scattering free memory over one list per stream. Each stream in a group
+ * keeps its own event, and a stream only waits on the events of the other streams in its group
+ * that have freed blocks since it last waited.
+ *
+ * The free list and event of a stream that is no longer used are reclaimed by
+ * `on_stream_destroyed()`, which is called automatically when a `cuda_stream` is destroyed, or by
+ * a sweep of the streams not used since the previous sweep (see `sweep_idle_streams()`). The
+ * blocks of a reclaimed free list are moved to the free list of the default stream, and its event
+ * is reused for the next new stream.
+ *
+ * Blocks freed on the default stream or on a per-thread default stream can optionally be kept in a
+ * cache local to the freeing thread (see `set_thread_cache_size()`), so that repeated allocations
+ * of the same size by that thread on the same stream take no shared lock at all. Since these
+ * streams are never destroyed and a cached block is only reused by the thread and on the stream
+ * that freed it, cached blocks need no event. Cached blocks are returned to the free list of their
+ * stream, as if just freed, when the cache overflows and when the thread exits.
+ *
+ * `expand_pool` is called with the global mutex held. `allocate_from_block` and `free_block` are
+ * called concurrently from multiple threads without it, so they must synchronize any state they
+ * share.
  */
-template <typename PoolResource, typename FreeListType>
+template <typename PoolResource,
+          typename FreeListType,
+          typename StreamBackend = cuda_stream_backend>
 class stream_ordered_memory_resource : public crtp<PoolResource>, public device_memory_resource {
  public:
   // TODO use rmm-level def of this.
   static constexpr size_t allocation_alignment = 256;
 
-  ~stream_ordered_memory_resource() { release(); }
+  ~stream_ordered_memory_resource()
+  {
+    stop_stream_destruction_callback();
+    detach_thread_caches();
+    release();
+  }
+
+  stream_ordered_memory_resource()
+    : stream_destruction_callback_id_{rmm::detail::stream_destruction_callbacks::add(
+        [this](cuda_stream_view stream) { on_stream_destroyed(stream); })}
+  {
+  }
 
-  stream_ordered_memory_resource()                                      = default;
   stream_ordered_memory_resource(stream_ordered_memory_resource const&) = delete;
   stream_ordered_memory_resource(stream_ordered_memory_resource&&)      = delete;
   stream_ordered_memory_resource& operator=(stream_ordered_memory_resource const&) = delete;
   stream_ordered_memory_resource& operator=(stream_ordered_memory_resource&&) = delete;
 
+  /**
+   * @brief Get the number of allocations satisfied from the free lists of other streams.
+   *
+   * @return std::size_t The number of cross-stream steals.
+   */
+  std::size_t get_steal_count() const noexcept { return steal_count_.load(); }
+
+  /**
+   * @brief Get the number of cross-stream steals from free lists whose work had already completed,
+   * so that the allocating stream did not have to wait on another stream.
+   *
+   * @return std::size_t The number of steals without a wait.
+   */
+  std::size_t get_free_steal_count() const noexcept { return free_steal_count_.load(); }
+
+  /**
+   * @brief Get the number of cross-stream steals that made the allocating stream wait on the
+   * event(s) of the free list stolen from, because work using its blocks may still be in flight.
+   *
+   * `get_free_steal_count() + get_ordered_steal_count() == get_steal_count()`
+   *
+   * @return std::size_t The number of steals with a wait.
+   */
+  std::size_t get_ordered_steal_count() const noexcept
+  {
+    return steal_count_.load() - free_steal_count_.load();
+  }
+
+  /**
+   * @brief Get the number of (non-empty) free lists of other streams merged into the free list of
+   * an allocating stream.
+   *
+   * Each merge makes the allocating stream wait on the event of the stream merged from.
+   *
+   * @return std::size_t The number of cross-stream free list merges.
+   */
+  std::size_t get_merge_count() const noexcept { return merge_count_.load(); }
+
+  /**
+   * @brief Set how often the event of a stream is recorded on deallocation.
+   *
+   * With an interval of 1 (the default) the event is recorded on every deallocation. With an
+   * interval of N > 1 it is recorded once every N deallocations on the stream, and with an interval
+   * of 0 it is not recorded on deallocation at all. In either case the event is recorded before
+   * another stream takes blocks from the stream's free list, if any blocks were freed since it was
+   * last recorded. This requires that a stream not be destroyed while blocks freed on it remain in
+   * the pool unless its event is up to date.
+   *
+   * The event of the per-thread default stream is always recorded on every deallocation, because
+   * that stream cannot be named from another thread.
+   *
+   * @param interval The number of deallocations per event record, or 0 to record only when
+   * another stream takes blocks.
+   */
+  void set_event_record_interval(std::size_t interval) noexcept
+  {
+    event_record_interval_ = interval;
+  }
+
+  /**
+   * @brief Get the number of deallocations per event record.
+   *
+   * @return std::size_t The event record interval. 0 means events are only recorded when another
+   * stream takes blocks.
+   */
+  std::size_t get_event_record_interval() const noexcept { return event_record_interval_.load(); }
+
+  /**
+   * @brief Get the number of streams whose free lists and events have been reclaimed.
+   *
+   * @return std::size_t The number of streams reclaimed by `on_stream_destroyed()` or by sweeps.
+   */
+  std::size_t get_reclaim_count() const noexcept { return reclaim_count_.load(); }
+
+  /**
+   * @brief Reclaim the free list and event of `stream`, which is about to be destroyed.
+   *
+   * Blocks freed on `stream` are moved to the free list of the default stream, after making the
+   * default stream wait on the event of `stream`, and the event is reused for the next new stream.
+   * Must be called before `stream` is destroyed and not concurrently with allocations or
+   * deallocations on it. Called automatically when a `cuda_stream` is destroyed. Does nothing for
+   * default streams, for streams not used with this resource, and for streams in a stream group.
+   *
+   * @param stream The stream that is about to be destroyed.
+   */
+  void on_stream_destroyed(cuda_stream_view stream)
+  {
+    if (stream.is_default() || stream.is_per_thread_default()) { return; }
+    {
+      read_lock streams_lock(streams_mtx_);
+      if (stream_events_.find(stream.value()) == stream_events_.end()) { return; }
+    }
+
+    lock_guard lock(mtx_);
+    write_lock streams_lock(streams_mtx_);
+    if (is_reclaimable(stream.value())) { reclaim_stream(stream.value()); }
+  }
+
+  /**
+   * @brief Reclaim the free lists and events of all streams not used since the previous sweep.
+   *
+   * A stream is used when memory is allocated or deallocated on it. A stream that is reclaimed but
+   * still alive simply gets a new free list when it is next used. The events of streams reclaimed
+   * must be up to date unless the streams are still alive (see `set_event_record_interval()`).
+   * Streams in a stream group and the default streams are never reclaimed.
+   *
+   * @return std::size_t The number of streams reclaimed.
+   */
+  std::size_t sweep_idle_streams()
+  {
+    lock_guard lock(mtx_);
+    return sweep();
+  }
+
+  /**
+   * @brief Set how often idle streams are swept automatically.
+   *
+   * With an interval of N > 0, `sweep_idle_streams()` is called on every Nth allocation that cannot
+   * be satisfied from the free list of its own stream. With 0 (the default) there are no automatic
+   * sweeps.
+   *
+   * @param interval The number of such allocations per sweep, or 0 to disable automatic sweeps.
+   */
+  void set_stream_sweep_interval(std::size_t interval) noexcept
+  {
+    stream_sweep_interval_ = interval;
+  }
+
+  /**
+   * @brief Get the number of allocations not satisfied from their stream's own free list per
+   * automatic sweep of idle streams.
+   *
+   * @return std::size_t The sweep interval, or 0 if automatic sweeps are disabled.
+   */
+  std::size_t get_stream_sweep_interval() const noexcept { return stream_sweep_interval_.load(); }
+
+  /**
+   * @brief Set the maximum number of bytes of freed blocks that each thread may cache.
+   *
+   * Blocks freed on the default stream or on a per-thread default stream, of at most `bytes`
+   * bytes, are kept in a cache local to the freeing thread, bucketed by size class. An allocation
+   * on the same stream of the same (aligned) size by the same thread is then satisfied from the
+   * cache without taking any shared lock. When a block would take the cache over `bytes`, the
+   * thread's cached blocks are first returned to the free lists of their streams, as are those of
+   * a thread that exits.
+   *
+   * Cached blocks remain allocated as far as the derived resource is concerned, e.g. for its
+   * statistics and when trimming a pool. With 0 (the default) no further blocks are cached; blocks
+   * already cached can still be reused until they are flushed.
+   *
+   * @param bytes The maximum number of bytes cached per thread, or 0 to disable caching.
+   */
+  void set_thread_cache_size(std::size_t bytes) noexcept
+  {
+    if (bytes != 0) { thread_caches_used_ = true; }
+    thread_cache_size_ = bytes;
+  }
+
+  /**
+   * @brief Get the maximum number of bytes of freed blocks that each thread may cache.
+   *
+   * @return std::size_t The per-thread cache size in bytes, or 0 if caching is disabled.
+   */
+  std::size_t get_thread_cache_size() const noexcept { return thread_cache_size_.load(); }
+
+  /**
+   * @brief Get the number of allocations satisfied from the threads' caches of freed blocks.
+   *
+   * @return std::size_t The number of thread cache hits, over all threads.
+   */
+  std::size_t get_thread_cache_hit_count() const
+  {
+    lock_guard lock(thread_caches_mtx_);
+    return std::accumulate(thread_caches_.begin(),
+                           thread_caches_.end(),
+                           retired_thread_cache_hits_,
+                           [](std::size_t sum, auto const& cache) { return sum + cache->hits; });
+  }
+
+  /**
+   * @brief Return all blocks in the calling thread's cache to the free lists of their streams.
+   */
+  void flush_thread_cache()
+  {
+    if (not thread_caches_used_) { return; }
+    auto& cache = local_thread_cache();
+    lock_guard lock(cache.mtx);
+    flush_thread_cache(cache);
+  }
+
+  /**
+   * @brief Make the streams in `streams` share one free list.
+   *
+   * Blocks freed on any stream in the group can be reused by any other stream in the group without
+   * merging free lists. Before reusing blocks from the group's free list, a stream waits on the
+   * event of each other stream in the group that has freed blocks since the stream last waited, so
+   * the streams themselves are not serialized. With an event record interval other than 1, the
+   * event of a stream in a group is recorded only when another stream needs to wait on it.
+   *
+   * @throws rmm::logic_error if `streams` is empty or contains a default stream, a duplicate, or a
+   * stream that has already been used with this resource.
+   *
+   * @param streams The streams to group.
+   */
+  void add_stream_group(std::vector<cuda_stream_view> const& streams)
+  {
+    RMM_EXPECTS(not streams.empty(), "Stream group must not be empty");
+
+    lock_guard lock(mtx_);
+    write_lock streams_lock(streams_mtx_);
+
+    std::unordered_map<cudaStream_t, group_member> members;
+    for (auto const& s : streams) {
+      RMM_EXPECTS(not s.is_default() && not s.is_per_thread_default(),
+                  "Default streams cannot be grouped");
+      RMM_EXPECTS(stream_events_.find(s.value()) == stream_events_.end(),
+                  "Stream has already been used with this memory resource");
+      RMM_EXPECTS(members.find(s.value()) == members.end(), "Duplicate stream in group");
+      members[s.value()].stream = s.value();
+    }
+    for (auto& m : members) {
+      RMM_CUDA_TRY(StreamBackend::create_event(&m.second.event));
+    }
+
+    // The free list is found by event, so every stream in the group maps to the same event
+    auto const group_event = members.at(streams.front().value()).event;
+    for (auto const& m : members) {
+      stream_events_[m.first] = stream_event_pair{m.first, group_event};
+    }
+
+    auto const key       = stream_event_pair{streams.front().value(), group_event};
+    auto& blocks         = stream_free_blocks_[key];
+    blocks.stream_event  = key;
+    blocks.group_members = std::move(members);
+    lock_guard summary_lock(summary_mtx_);
+    blocks.summary_index = summary_.size();
+    summary_.push_back(&blocks);
+  }
+
  protected:
   using free_list  = FreeListType;
   using block_type = typename free_list::block_type;
   using lock_guard = std::lock_guard<std::mutex>;
+  using read_lock  = std::shared_lock<std::shared_timed_mutex>;
+  using write_lock = std::unique_lock<std::shared_timed_mutex>;
 
-  // Derived classes must implement these four methods
+  // Derived classes must implement these five methods
 
   /**
    * @brief Get the maximum size of a single allocation supported by this suballocator memory
@@ -112,6 +421,9 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
    * the latter case, the function returns one block and inserts all the rest into the free list
    * `blocks`.
    *
+   * Called with the global mutex held. `blocks` is initially empty; its contents are added to the
+   * free list of `stream` afterwards.
+   *
    * @param size The minimum size block to return
    * @param blocks The free list into which to optionally insert new blocks
    * @param stream The stream on which the memory is to be used.
@@ -149,6 +461,60 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
    */
   // block_type free_block(void* p, size_t size) noexcept
 
+  /**
+   * @brief Get the largest available block size and total free size over all free lists.
+   *
+   * Used for trace logging after every allocation and deallocation, so it should not need to
+   * visit every free block. Called without any free list mutex held.
+   *
+   * @return std::pair<std::size_t, std::size_t> Pair of largest available block, total free size
+   */
+  // std::pair<std::size_t, std::size_t> free_summary() const
+
+  /**
+   * @brief Get the size of the largest block in free list `blocks`.
+   *
+   * Called with the mutex of `blocks` held after every change to it, to maintain the summary. The
+   * default implementation calls `blocks.largest_block_size()`. Derived classes whose free list
+   * type does not record block sizes must override this function.
+   *
+   * @param blocks The free list.
+   * @return std::size_t The size in bytes of the largest block in `blocks`, or 0 if it is empty.
+   */
+  std::size_t largest_block_size(free_list const& blocks) const
+  {
+    return blocks.largest_block_size();
+  }
+
+  /**
+   * @brief Remove and return a block large enough for `size` bytes from free list `blocks`.
+   *
+   * Called with the mutex of `blocks` held whenever a block is taken from a free list. The default
+   * implementation calls `blocks.get_block(size)`. Derived classes may override this function to
+   * choose the block by a different placement policy.
+   *
+   * @param blocks The free list.
+   * @param size The size in bytes of the requested allocation.
+   * @return block_type A block of at least `size` bytes, or an invalid block if there is none.
+   */
+  block_type get_block_from_list(free_list& blocks, size_t size)
+  {
+    return blocks.get_block(size);
+  }
+
+  /**
+   * @brief Get the size of the largest free block in any stream's free list.
+   *
+   * Reads the top of the summary, so takes constant time.
+   *
+   * @return std::size_t The size in bytes of the largest free block.
+   */
+  std::size_t get_largest_free_block_size() const
+  {
+    lock_guard lock(summary_mtx_);
+    return summary_.empty() ? 0 : summary_.front()->largest;
+  }
+
   /**
    * @brief Returns the block `b` (last used on stream `stream_event`) to the pool.
    *
@@ -157,31 +523,107 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
    */
   void insert_block(block_type const& b, cuda_stream_view stream)
   {
-    stream_free_blocks_[get_event(stream)].insert(b);
+    auto const pinned = pin_free_list(stream);
+    auto& blocks      = *pinned.blocks;
+    lock_guard lock(blocks.mtx);
+    blocks.blocks.insert(b);
+    update_summary(blocks);
+  }
+
+  /**
+   * @brief Returns the block `b`, which is in use on no stream, to the free list of the non-default
+   * stream `stream` if the stream has one, i.e. it has not been reclaimed since it was last used.
+   *
+   * Unlike `insert_block()`, this never adds a free list, so it may be called with a stream that
+   * has since been destroyed.
+   *
+   * @param b The block to insert into the pool.
+   * @param stream The stream to whose free list to add the block.
+   * @return true if the block was inserted, false if `stream` has no free list.
+   */
+  bool insert_block_if_tracked(block_type const& b, cudaStream_t stream)
+  {
+    read_lock streams_lock(streams_mtx_);
+    auto const event = stream_events_.find(stream);
+    if (event == stream_events_.end()) { return false; }
+    auto const iter = stream_free_blocks_.find(event->second);
+    if (iter == stream_free_blocks_.end()) { return false; }
+
+    auto& blocks = iter->second;
+    lock_guard lock(blocks.mtx);
+    blocks.blocks.insert(b);
+    update_summary(blocks);
+    return true;
   }
 
-  void insert_blocks(free_list&& blocks, cuda_stream_view stream)
+  void insert_blocks(free_list&& other, cuda_stream_view stream)
   {
-    stream_free_blocks_[get_event(stream)].insert(std::move(blocks));
+    auto const pinned = pin_free_list(stream);
+    auto& blocks      = *pinned.blocks;
+    lock_guard lock(blocks.mtx);
+    blocks.blocks.insert(std::move(other));
+    update_summary(blocks);
   }
 
   void print_free_blocks() const
   {
     std::cout << "stream free blocks: ";
-    for (auto s : stream_free_blocks_) {
-      std::cout << "stream: " << s.first.stream << " event: " << s.first.event << " ";
-      s.second.print();
+    for_each_free_list([](auto const& stream_event, free_list const& blocks) {
+      std::cout << "stream: " << stream_event.stream << " event: " << stream_event.event << " ";
+      blocks.print();
       std::cout << std::endl;
-    }
+    });
     std::cout << std::endl;
   }
 
   /**
-   * @brief Get the mutex object
+   * @brief Calls `f(stream_event, blocks, synchronize)` for each stream's free list.
+   *
+   * Each free list is locked while `f` is called on it. Blocks may be erased from `blocks` by `f`,
+   * but blocks last used on `stream_event.stream` must not be reused or returned upstream before
+   * `stream_event.event` has completed, so the event is recorded before `f` is called if it is not
+   * up to date. `f` can call `synchronize()` to wait for it, or for the events of all streams of a
+   * stream group, whose free list is keyed by the stream and event of its first stream. The summary
+   * is updated after each call. The caller must not hold any free list mutex.
+   *
+   * @param f The function to call for each (stream_event_pair, free_list&, synchronize) triple.
+   */
+  template <typename Function>
+  void for_each_free_list(Function&& f)
+  {
+    read_lock streams_lock(streams_mtx_);
+    for (auto& s : stream_free_blocks_) {
+      lock_guard lock(s.second.mtx);
+      record_pending_events(s.second);
+      f(s.first, s.second.blocks, [this, &s]() { synchronize_events(s.second); });
+      update_summary(s.second);
+    }
+  }
+
+  /**
+   * @brief Calls `f(stream_event, blocks)` for each stream's free list, which `f` must not modify.
+   *
+   * Each free list is locked while `f` is called on it. The caller must not hold any free list
+   * mutex.
+   *
+   * @param f The function to call for each (stream_event_pair, free_list const&) pair.
+   */
+  template <typename Function>
+  void for_each_free_list(Function&& f) const
+  {
+    read_lock streams_lock(streams_mtx_);
+    for (auto const& s : stream_free_blocks_) {
+      lock_guard lock(s.second.mtx);
+      f(s.first, s.second.blocks);
+    }
+  }
+
+  /**
+   * @brief Get the global mutex, which serializes stealing, merging and expanding the pool.
    *
    * @return std::mutex
    */
-  std::mutex& get_mutex() { return mtx_; }
+  std::mutex& get_mutex() const { return mtx_; }
 
   struct stream_event_pair {
     cudaStream_t stream;
@@ -207,17 +649,26 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
 
     if (bytes <= 0) return nullptr;
 
-    lock_guard lock(mtx_);
-
-    auto stream_event = get_event(stream);
-
     bytes = rmm::detail::align_up(bytes, allocation_alignment);
     RMM_EXPECTS(bytes <= this->underlying().get_maximum_allocation_size(),
                 rmm::bad_alloc,
                 "Maximum allocation size exceeded");
-    auto const b = this->underlying().get_block(bytes, stream_event);
+
+    if (thread_caches_used_.load(std::memory_order_relaxed)) {
+      void* const p = allocate_from_thread_cache(bytes, stream);
+      if (p != nullptr) { return p; }
+    }
+
+    auto const pinned       = pin_free_list(stream);
+    auto const stream_event = pinned.stream_event;
+    auto& blocks            = *pinned.blocks;
+    auto const b            = this->underlying().get_block(bytes, stream_event, blocks);
     auto split   = this->underlying().allocate_from_block(b, bytes);
-    if (split.remainder.is_valid()) stream_free_blocks_[stream_event].insert(split.remainder);
+    if (split.remainder.is_valid()) {
+      lock_guard lock(blocks.mtx);
+      blocks.blocks.insert(split.remainder);
+      update_summary(blocks);
+    }
     RMM_LOG_TRACE("[A][stream {:p}][{}B][{:p}]",
                   fmt::ptr(stream_event.stream),
                   bytes,
@@ -237,33 +688,197 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
    */
   virtual void do_deallocate(void* p, std::size_t bytes, cuda_stream_view stream) override
   {
-    lock_guard lock(mtx_);
-    auto stream_event = get_event(stream);
-    RMM_LOG_TRACE("[D][stream {:p}][{}B][{:p}]", fmt::ptr(stream_event.stream), bytes, p);
+    auto const aligned_bytes = rmm::detail::align_up(bytes, allocation_alignment);
+    if (p != nullptr && aligned_bytes <= thread_cache_size_.load(std::memory_order_relaxed) &&
+        deallocate_to_thread_cache(p, aligned_bytes, stream)) {
+      RMM_LOG_TRACE("[D][stream {:p}][{}B][{:p}][Cached]", fmt::ptr(stream.value()), bytes, p);
+      return;
+    }
 
-    bytes        = rmm::detail::align_up(bytes, allocation_alignment);
-    auto const b = this->underlying().free_block(p, bytes);
+    auto const pinned       = pin_free_list(stream);
+    auto const stream_event = pinned.stream_event;
+    RMM_LOG_TRACE("[D][stream {:p}][{}B][{:p}]", fmt::ptr(stream_event.stream), bytes, p);
 
-    // TODO: cudaEventRecord has significant overhead on deallocations. For the non-PTDS case
-    // we may be able to delay recording the event in some situations. But using events rather than
-    // streams allows stealing from deleted streams.
-    RMM_ASSERT_CUDA_SUCCESS(cudaEventRecord(stream_event.event, stream.value()));
+    auto const b = this->underlying().free_block(p, aligned_bytes);
 
-    stream_free_blocks_[stream_event].insert(b);
+    auto& blocks = *pinned.blocks;
+    {
+      // The event is recorded (or the epoch advanced) with the free list locked so that a thread
+      // stealing from this list always waits on an event recorded after every block in it was
+      // freed.
+      lock_guard lock(blocks.mtx);
+      note_free(blocks, stream_event.event, stream.value());
+      blocks.blocks.insert(b);
+      update_summary(blocks);
+    }
 
     log_summary_trace();
   }
 
+  /**
+   * @brief Stop calling `on_stream_destroyed()` when a `cuda_stream` is destroyed, waiting for any
+   * call in progress to return.
+   *
+   * Called on destruction, since `on_stream_destroyed()` needs the derived resource. Derived
+   * classes whose destructors release memory must call this first.
+   */
+  void stop_stream_destruction_callback()
+  {
+    if (stream_destruction_callback_id_ == 0) { return; }
+    rmm::detail::stream_destruction_callbacks::remove(stream_destruction_callback_id_);
+    stream_destruction_callback_id_ = 0;
+  }
+
+  /**
+   * @brief Detach the caches of all threads from this resource, discarding their blocks.
+   *
+   * Called on destruction, since flushing a cache on thread exit needs the derived resource.
+   * Derived classes whose destructors release memory must call this first.
+   */
+  void detach_thread_caches()
+  {
+    lock_guard lock(thread_caches_mtx_);
+    for (auto const& cache : thread_caches_) {
+      lock_guard cache_lock(cache->mtx);
+      cache->owner = nullptr;
+      for (auto& m : cache->magazines) {
+        for (auto& bin : m.bins) {
+          bin.clear();
+        }
+      }
+      cache->bytes = 0;
+    }
+    thread_caches_.clear();
+  }
+
  private:
   /**
-   * @brief RAII wrapper for a CUDA event.
+   * @brief A stream in a stream group and its event.
+   *
+   * Epochs are those of the group's free list.
    */
-  struct event_wrapper {
-    event_wrapper()
+  struct group_member {
+    cudaStream_t stream{};
+    cudaEvent_t event{};
+    std::size_t freed_epoch{};     // epoch of the last free or merge into the list on this stream
+    std::size_t recorded_epoch{};  // value of freed_epoch when the event was last recorded
+    std::size_t waited_epoch{};    // epoch up to which this stream has waited on the other streams
+  };
+
+  /**
+   * @brief A free list, the mutex that guards it, and its entry in the summary.
+   */
+  struct stream_free_list {
+    free_list blocks;
+    mutable std::mutex mtx;
+    stream_event_pair stream_event{};  // the key of this free list
+    std::size_t largest{};             // largest block size. Written with mtx and summary_mtx_ held
+    std::size_t summary_index{};       // position in summary_. Guarded by summary_mtx_
+    bool record_eagerly{};             // record the event on every deallocation (per-thread stream)
+    std::size_t epoch{};               // number of frees and merges into the list
+    std::size_t recorded_epoch{};      // value of epoch when the event was last recorded
+    // The streams sharing this list if it belongs to a stream group, otherwise empty. The map
+    // itself is not modified after the group is added; its elements are guarded by mtx.
+    std::unordered_map<cudaStream_t, group_member> group_members;
+    std::atomic<std::size_t> pins{};       // threads using the list, which is then not reclaimed
+    std::atomic<std::size_t> last_used{};  // sweep generation in which the list was last pinned
+  };
+
+  /**
+   * @brief A stream's event and free list, pinned so that the list is not reclaimed while in use.
+   */
+  struct pinned_free_list {
+    // Must be constructed with the stream map lock held
+    pinned_free_list(stream_event_pair stream_event_, stream_free_list* blocks_) noexcept
+      : stream_event{stream_event_}, blocks{blocks_}
+    {
+      ++blocks->pins;
+    }
+
+    pinned_free_list(pinned_free_list&& other) noexcept
+      : stream_event{other.stream_event}, blocks{other.blocks}
+    {
+      other.blocks = nullptr;
+    }
+
+    ~pinned_free_list()
+    {
+      if (blocks != nullptr) { --blocks->pins; }
+    }
+
+    pinned_free_list(pinned_free_list const&) = delete;
+    pinned_free_list& operator=(pinned_free_list const&) = delete;
+    pinned_free_list& operator=(pinned_free_list&&) = delete;
+
+    stream_event_pair stream_event;  // the event of the stream, or of its group
+    stream_free_list* blocks;
+  };
+
+  /// The most free lists of other streams checked for a completed block per allocation
+  static constexpr std::size_t max_steal_candidates = 8;
+
+  /// Blocks of up to 2^(i+1) * allocation_alignment bytes are in size class i of a thread cache
+  static constexpr std::size_t thread_cache_size_classes = 32;
+
+  struct cached_block {
+    void* pointer;
+    std::size_t size;  // aligned
+  };
+
+  /**
+   * @brief The blocks cached by a thread that were freed on one default stream, by size class.
+   */
+  struct magazine {
+    stream_event_pair stream_event{};  // set when the first block is cached
+    std::array<std::vector<cached_block>, thread_cache_size_classes> bins;
+  };
+
+  /**
+   * @brief A thread's cache of freed blocks for one resource.
+   *
+   * The mutex is only contended when the resource is destroyed, or its counters read, while the
+   * thread uses the cache.
+   */
+  struct thread_cache {
+    explicit thread_cache(stream_ordered_memory_resource* mr) : owner{mr} {}
+
+    std::mutex mtx;
+    std::atomic<stream_ordered_memory_resource*> owner;  // nullptr once detached
+    std::array<magazine, 2> magazines;  // for the default and the per-thread default stream
+    std::size_t bytes{};                // bytes cached in all magazines
+    std::atomic<std::size_t> hits{};
+  };
+
+  /**
+   * @brief The caches of a thread for all resources it has used, flushed when the thread exits.
+   */
+  struct thread_caches {
+    thread_caches() = default;
+    thread_caches(thread_caches const&) = delete;
+    thread_caches& operator=(thread_caches const&) = delete;
+
+    ~thread_caches()
     {
-      RMM_ASSERT_CUDA_SUCCESS(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      for (auto const& c : caches) {
+        auto& cache = *c.second;
+        lock_guard lock(cache.mtx);
+        auto* const owner = cache.owner.load();
+        if (owner != nullptr) {
+          owner->flush_thread_cache(cache);
+          cache.owner = nullptr;
+        }
+      }
     }
-    ~event_wrapper() { RMM_ASSERT_CUDA_SUCCESS(cudaEventDestroy(event)); }
+
+    std::unordered_map<stream_ordered_memory_resource const*, std::shared_ptr<thread_cache>> caches;
+  };
+
+  /**
+   * @brief RAII wrapper for a CUDA event.
+   */
+  struct event_wrapper {
+    event_wrapper() { RMM_ASSERT_CUDA_SUCCESS(StreamBackend::create_event(&event)); }
+    ~event_wrapper() { RMM_ASSERT_CUDA_SUCCESS(StreamBackend::destroy_event(event)); }
     cudaEvent_t event{};
   };
 
@@ -283,8 +898,16 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
       // Create a thread-local shared event wrapper. Shared pointers in the thread and in each MR
       // instance ensures it is destroyed cleaned up only after all are finished with it.
       thread_local auto event_tls = std::make_shared<event_wrapper>();
+      auto const stream_event     = stream_event_pair{stream.value(), event_tls.get()->event};
+      {
+        read_lock lock(streams_mtx_);
+        if (default_stream_events.find(event_tls) != default_stream_events.end()) {
+          return stream_event;
+        }
+      }
+      write_lock lock(streams_mtx_);
       default_stream_events.insert(event_tls);
-      return stream_event_pair{stream.value(), event_tls.get()->event};
+      return stream_event;
     }
     // We use cudaStreamLegacy as the event map key for the default stream for consistency between
     // PTDS and non-PTDS mode. In PTDS mode, the cudaStreamLegacy map key will only exist if the
@@ -293,127 +916,843 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
     // mode.
     auto const stream_to_store = stream.is_default() ? cudaStreamLegacy : stream.value();
 
-    auto const iter = stream_events_.find(stream_to_store);
-    return (iter != stream_events_.end()) ? iter->second : [&]() {
-      stream_event_pair stream_event{stream_to_store};
-      RMM_ASSERT_CUDA_SUCCESS(
-        cudaEventCreateWithFlags(&stream_event.event, cudaEventDisableTiming));
-      stream_events_[stream_to_store] = stream_event;
-      return stream_event;
-    }();
-  }
-
+    {
+      read_lock lock(streams_mtx_);
+      auto const iter = stream_events_.find(stream_to_store);
+      if (iter != stream_events_.end()) { return iter->second; }
+    }
+
+    write_lock lock(streams_mtx_);
+    return get_or_add_event(stream_to_store);
+  }
+
+  /**
+   * @brief Get the stream_event of non-per-thread stream `stream`, adding it if it does not exist.
+   *
+   * A reclaimed event is reused if there is one. The caller must hold the stream map lock
+   * exclusively.
+   */
+  stream_event_pair get_or_add_event(cudaStream_t stream)
+  {
+    auto const iter = stream_events_.find(stream);
+    if (iter != stream_events_.end()) { return iter->second; }
+
+    stream_event_pair stream_event{stream};
+    if (reclaimed_events_.empty()) {
+      RMM_ASSERT_CUDA_SUCCESS(StreamBackend::create_event(&stream_event.event));
+    } else {
+      stream_event.event = reclaimed_events_.back();
+      reclaimed_events_.pop_back();
+    }
+    stream_events_[stream] = stream_event;
+    return stream_event;
+  }
+
+  /**
+   * @brief Get the event and free list of `stream`, creating them if they do not exist.
+   *
+   * The free list is pinned, so that it is not reclaimed, until the returned object is destroyed.
+   *
+   * @param stream The stream whose free list to get.
+   * @return pinned_free_list The stream_event of `stream` and its free list.
+   */
+  pinned_free_list pin_free_list(cuda_stream_view stream)
+  {
+    auto const pin = [this](stream_event_pair stream_event, stream_free_list& blocks) {
+      blocks.last_used.store(sweep_generation_, std::memory_order_relaxed);
+      return pinned_free_list{stream_event, &blocks};
+    };
+
+    while (true) {
+      auto const stream_event = get_event(stream);
+      {
+        read_lock lock(streams_mtx_);
+        auto const iter = stream_free_blocks_.find(stream_event);
+        if (is_current(stream, stream_event) && iter != stream_free_blocks_.end()) {
+          return pin(stream_event, iter->second);
+        }
+      }
+      write_lock lock(streams_mtx_);
+      if (is_current(stream, stream_event)) {
+        return pin(stream_event, get_or_add_free_list(stream_event));
+      }
+      // The stream was reclaimed after its event was found, so find it again
+    }
+  }
+
+  /**
+   * @brief Get the free list of a default stream, which is never reclaimed, creating it if it does
+   * not exist. Unlike `pin_free_list()` this does not call `get_event()`, so it can be used while
+   * a thread exits.
+   *
+   * @param stream_event The stream_event of a default stream.
+   * @return pinned_free_list The free list of `stream_event`.
+   */
+  pinned_free_list pin_default_free_list(stream_event_pair stream_event)
+  {
+    {
+      read_lock lock(streams_mtx_);
+      auto const iter = stream_free_blocks_.find(stream_event);
+      if (iter != stream_free_blocks_.end()) {
+        return pinned_free_list{stream_event, &iter->second};
+      }
+    }
+    write_lock lock(streams_mtx_);
+    return pinned_free_list{stream_event, &get_or_add_free_list(stream_event)};
+  }
+
+  /**
+   * @brief Returns the index of the thread cache magazine for blocks freed on `stream`, or -1 if
+   * blocks freed on `stream` are not cached.
+   */
+  static int thread_cache_magazine(cuda_stream_view stream) noexcept
+  {
+    if (stream.is_per_thread_default()) { return 1; }
+    return stream.is_default() ? 0 : -1;
+  }
+
+  /// Returns the size class in a thread cache of blocks of `size` (aligned) bytes.
+  static std::size_t thread_cache_size_class(std::size_t size) noexcept
+  {
+    std::size_t size_class{0};
+    for (auto units = (size - 1) / allocation_alignment; units > 1; units >>= 1) {
+      ++size_class;
+    }
+    return std::min(size_class, thread_cache_size_classes - 1);
+  }
+
+  /**
+   * @brief Get the calling thread's cache for this resource, creating it if it does not exist.
+   */
+  thread_cache& local_thread_cache()
+  {
+    thread_local thread_caches caches{};
+    auto& cache = caches.caches[this];
+    if (cache == nullptr || cache->owner.load() != this) {
+      // Either new, or left by a destroyed resource at the same address
+      cache = std::make_shared<thread_cache>(this);
+      lock_guard lock(thread_caches_mtx_);
+      // Caches of threads that have exited are only referenced here, so drop them
+      auto const exited =
+        std::remove_if(thread_caches_.begin(), thread_caches_.end(), [](auto const& c) {
+          return c->owner.load() == nullptr;
+        });
+      std::for_each(exited, thread_caches_.end(), [this](auto const& c) {
+        retired_thread_cache_hits_ += c->hits;
+      });
+      thread_caches_.erase(exited, thread_caches_.end());
+      thread_caches_.push_back(cache);
+    }
+    return *cache;
+  }
+
+  /**
+   * @brief Take a block of exactly `size` (aligned) bytes freed on `stream` from the calling
+   * thread's cache.
+   *
+   * @return void* The block, or nullptr if there is no such block in the cache.
+   */
+  void* allocate_from_thread_cache(std::size_t size, cuda_stream_view stream)
+  {
+    auto const index = thread_cache_magazine(stream);
+    if (index < 0) { return nullptr; }
+
+    auto& cache = local_thread_cache();
+    lock_guard lock(cache.mtx);
+    auto& bin = cache.magazines[index].bins[thread_cache_size_class(size)];
+    // Most recently freed first, as it is the most likely to still be in the cache of the device
+    auto const iter = std::find_if(
+      bin.rbegin(), bin.rend(), [size](cached_block const& b) { return b.size == size; });
+    if (iter == bin.rend()) { return nullptr; }
+
+    auto* const p = iter->pointer;
+    bin.erase(std::next(iter).base());
+    cache.bytes -= size;
+    ++cache.hits;
+    RMM_LOG_TRACE("[A][stream {:p}][{}B][{:p}][Cached]", fmt::ptr(stream.value()), size, p);
+    return p;
+  }
+
+  /**
+   * @brief Put the block `p` of `size` (aligned) bytes freed on `stream` in the calling thread's
+   * cache, first flushing the cache if the block would take it over its size.
+   *
+   * @return bool true if the block was cached, false if blocks freed on `stream` are not cached.
+   */
+  bool deallocate_to_thread_cache(void* p, std::size_t size, cuda_stream_view stream)
+  {
+    auto const index = thread_cache_magazine(stream);
+    if (index < 0) { return false; }
+
+    auto& cache = local_thread_cache();
+    lock_guard lock(cache.mtx);
+    auto& m = cache.magazines[index];
+    if (m.stream_event.event == nullptr) { m.stream_event = get_event(stream); }
+    if (cache.bytes + size > thread_cache_size_.load(std::memory_order_relaxed)) {
+      flush_thread_cache(cache);
+    }
+    m.bins[thread_cache_size_class(size)].push_back(cached_block{p, size});
+    cache.bytes += size;
+    return true;
+  }
+
+  /**
+   * @brief Return all blocks in `cache` to the free lists of their streams, as if just freed.
+   *
+   * The caller must hold the mutex of `cache`, which must be attached to this resource.
+   */
+  void flush_thread_cache(thread_cache& cache)
+  {
+    for (auto& m : cache.magazines) {
+      std::vector<block_type> freed;
+      for (auto& bin : m.bins) {
+        for (auto const& b : bin) {
+          freed.push_back(this->underlying().free_block(b.pointer, b.size));
+        }
+        bin.clear();
+      }
+      if (freed.empty()) { continue; }
+
+      auto const pinned = pin_default_free_list(m.stream_event);
+      auto& blocks      = *pinned.blocks;
+      lock_guard lock(blocks.mtx);
+      note_free(blocks, m.stream_event.event, m.stream_event.stream);
+      for (auto const& b : freed) {
+        blocks.blocks.insert(b);
+      }
+      update_summary(blocks);
+    }
+    cache.bytes = 0;
+  }
+
+  /**
+   * @brief Returns true if `stream_event` is still the stream_event of `stream`, i.e. the stream
+   * has not been reclaimed since. The caller must hold the stream map lock.
+   */
+  bool is_current(cuda_stream_view stream, stream_event_pair stream_event) const
+  {
+    if (stream.is_per_thread_default()) { return true; }
+    auto const iter = stream_events_.find(stream.is_default() ? cudaStreamLegacy : stream.value());
+    return iter != stream_events_.end() && iter->second.event == stream_event.event;
+  }
+
+  /**
+   * @brief Get the free list associated with `stream_event`, creating it if it does not exist.
+   *
+   * The caller must hold the stream map lock exclusively.
+   *
+   * @param stream_event The stream and associated event whose free list to get.
+   * @return stream_free_list& The free list and its mutex.
+   */
+  stream_free_list& get_or_add_free_list(stream_event_pair stream_event)
+  {
+    auto const iter = stream_free_blocks_.find(stream_event);
+    if (iter != stream_free_blocks_.end()) { return iter->second; }
+
+    auto& blocks          = stream_free_blocks_[stream_event];
+    blocks.stream_event   = stream_event;
+    blocks.record_eagerly = cuda_stream_view{stream_event.stream}.is_per_thread_default();
+    lock_guard summary_lock(summary_mtx_);
+    blocks.summary_index = summary_.size();
+    summary_.push_back(&blocks);  // an empty list goes at the bottom of the heap
+    return blocks;
+  }
+
+  /**
+   * @brief Record the event of free list `blocks` on its stream, bringing it up to date.
+   *
+   * The caller must hold the mutex of `blocks`.
+   *
+   * @param blocks The free list whose event to record.
+   * @return cudaError_t The result of recording the event.
+   */
+  cudaError_t record_event(stream_free_list& blocks)
+  {
+    blocks.recorded_epoch = blocks.epoch;
+    return StreamBackend::record_event(blocks.stream_event.event, blocks.stream_event.stream);
+  }
+
+  /**
+   * @brief Record the event of stream group member `member` on its stream.
+   *
+   * The caller must hold the mutex of the group's free list.
+   *
+   * @param member The member whose event to record.
+   * @return cudaError_t The result of recording the event.
+   */
+  cudaError_t record_event(group_member& member)
+  {
+    member.recorded_epoch = member.freed_epoch;
+    return StreamBackend::record_event(member.event, member.stream);
+  }
+
+  /**
+   * @brief Record every event of free list `blocks` that is not up to date.
+   *
+   * The caller must hold the mutex of `blocks`.
+   */
+  void record_pending_events(stream_free_list& blocks)
+  {
+    if (blocks.group_members.empty()) {
+      if (blocks.epoch != blocks.recorded_epoch) { RMM_CUDA_TRY(record_event(blocks)); }
+      return;
+    }
+    for (auto& m : blocks.group_members) {
+      if (m.second.freed_epoch != m.second.recorded_epoch) { RMM_CUDA_TRY(record_event(m.second)); }
+    }
+  }
+
+  /**
+   * @brief Returns true if all work that may use the blocks in free list `blocks` has completed,
+   * so that they can be used on any stream without a wait. Does not block.
+   *
+   * A free list with an event that is not up to date is treated as still in use. The caller must
+   * hold the mutex of `blocks`.
+   */
+  bool has_completed(stream_free_list const& blocks) const
+  {
+    auto const completed = [](cudaEvent_t event) {
+      auto const result = StreamBackend::query_event(event);
+      if (result != cudaErrorNotReady) { RMM_CUDA_TRY(result); }
+      return result == cudaSuccess;
+    };
+    if (blocks.group_members.empty()) {
+      return blocks.epoch == blocks.recorded_epoch && completed(blocks.stream_event.event);
+    }
+    return std::all_of(
+      blocks.group_members.begin(), blocks.group_members.end(), [&completed](auto const& m) {
+        return m.second.freed_epoch == 0 ||
+               (m.second.freed_epoch == m.second.recorded_epoch && completed(m.second.event));
+      });
+  }
+
+  /**
+   * @brief Block until the blocks in free list `blocks`, whose events are up to date, are no longer
+   * in use by work on any stream.
+   *
+   * The caller must hold the mutex of `blocks`.
+   */
+  void synchronize_events(stream_free_list const& blocks)
+  {
+    if (blocks.group_members.empty()) {
+      RMM_CUDA_TRY(StreamBackend::synchronize_event(blocks.stream_event.event));
+      return;
+    }
+    for (auto const& m : blocks.group_members) {
+      if (m.second.freed_epoch != 0) {
+        RMM_CUDA_TRY(StreamBackend::synchronize_event(m.second.event));
+      }
+    }
+  }
+
+  /**
+   * @brief Advance the epoch of free list `blocks` after blocks are freed into it on `stream`, and
+   * record `event`, the event of `stream`, if required by the event record interval.
+   *
+   * cudaEventRecord has significant overhead on deallocations, so unless recording eagerly it is
+   * deferred until `interval` blocks have been freed or another stream steals from the list. The
+   * caller must hold the mutex of `blocks`.
+   */
+  void note_free(stream_free_list& blocks, cudaEvent_t event, cudaStream_t stream)
+  {
+    auto const interval = event_record_interval_.load(std::memory_order_relaxed);
+    if (not blocks.group_members.empty()) {
+      auto& member = blocks.group_members.at(stream);
+      note_group_free(blocks, member);
+      if (interval == 1) { RMM_ASSERT_CUDA_SUCCESS(record_event(member)); }
+      return;
+    }
+    ++blocks.epoch;
+    if (blocks.record_eagerly || interval == 1) {
+      blocks.recorded_epoch = blocks.epoch;
+      RMM_ASSERT_CUDA_SUCCESS(StreamBackend::record_event(event, stream));
+    } else if (interval > 1 && blocks.epoch - blocks.recorded_epoch >= interval) {
+      RMM_ASSERT_CUDA_SUCCESS(record_event(blocks));
+    }
+  }
+
+  /**
+   * @brief Advance the epoch of the free list `blocks` of a stream group after blocks are added to
+   * it on the stream of `member`.
+   *
+   * The caller must hold the mutex of `blocks`.
+   */
+  void note_group_free(stream_free_list& blocks, group_member& member)
+  {
+    // A stream that had waited on all other frees remains up to date after its own
+    auto const up_to_date = member.waited_epoch == blocks.epoch;
+    member.freed_epoch    = ++blocks.epoch;
+    if (up_to_date) { member.waited_epoch = blocks.epoch; }
+  }
+
+  /**
+   * @brief Make `stream`, a member of the stream group of free list `blocks`, wait on the events of
+   * the other members that have freed blocks since it last waited, so that it can reuse any block
+   * in `blocks`.
+   *
+   * The caller must hold the mutex of `blocks`.
+   */
+  void wait_for_group(stream_free_list& blocks, cudaStream_t stream)
+  {
+    auto& self = blocks.group_members.at(stream);
+    if (self.waited_epoch == blocks.epoch) { return; }
+    for (auto& m : blocks.group_members) {
+      auto& other = m.second;
+      if (&other == &self || other.freed_epoch <= self.waited_epoch) { continue; }
+      if (other.freed_epoch != other.recorded_epoch) { RMM_CUDA_TRY(record_event(other)); }
+      RMM_CUDA_TRY(StreamBackend::stream_wait_event(stream, other.event));
+    }
+    self.waited_epoch = blocks.epoch;
+  }
+
+  /**
+   * @brief Make `stream` wait until all blocks in free list `other` (of another stream or stream
+   * group) are safe to use on it, recording events first if they are not up to date.
+   *
+   * The caller must hold the mutex of `other`.
+   */
+  void wait_for_list(stream_free_list& other, cudaStream_t stream)
+  {
+    record_pending_events(other);
+    if (other.group_members.empty()) {
+      RMM_CUDA_TRY(StreamBackend::stream_wait_event(stream, other.stream_event.event));
+      return;
+    }
+    for (auto const& m : other.group_members) {
+      if (m.second.freed_epoch != 0) {
+        RMM_CUDA_TRY(StreamBackend::stream_wait_event(stream, m.second.event));
+      }
+    }
+  }
+
+  /**
+   * @brief Make the allocating stream wait as needed to reuse a block taken from its own free list
+   * `blocks`. Only the streams of a stream group need to wait.
+   *
+   * The caller must hold the mutex of `blocks`.
+   */
+  void wait_for_own_list(stream_free_list& blocks, cudaStream_t stream)
+  {
+    if (not blocks.group_members.empty()) { wait_for_group(blocks, stream); }
+  }
+
+  /**
+   * @brief Update the summary entry of free list `blocks` after it has changed.
+   *
+   * The caller must hold the mutex of `blocks`. The summary mutex is only taken if the size of the
+   * largest block has changed.
+   *
+   * @param blocks The free list that has changed.
+   */
+  void update_summary(stream_free_list& blocks)
+  {
+    auto const largest = this->underlying().largest_block_size(blocks.blocks);
+    if (largest == blocks.largest) { return; }
+
+    lock_guard lock(summary_mtx_);
+    blocks.largest = largest;
+    sift_up(blocks.summary_index);
+    sift_down(blocks.summary_index);
+  }
+
+  /**
+   * @brief Remove free list `blocks` from the summary. The caller must hold the summary mutex.
+   */
+  void summary_erase(stream_free_list& blocks)
+  {
+    auto const i = blocks.summary_index;
+    summary_swap(i, summary_.size() - 1);
+    summary_.pop_back();
+    if (i < summary_.size()) {
+      sift_up(i);
+      sift_down(i);
+    }
+  }
+
+  void summary_swap(std::size_t i, std::size_t j)
+  {
+    std::swap(summary_[i], summary_[j]);
+    summary_[i]->summary_index = i;
+    summary_[j]->summary_index = j;
+  }
+
+  void sift_up(std::size_t i)
+  {
+    while (i > 0) {
+      auto const parent = (i - 1) / 2;
+      if (summary_[parent]->largest >= summary_[i]->largest) { return; }
+      summary_swap(i, parent);
+      i = parent;
+    }
+  }
+
+  void sift_down(std::size_t i)
+  {
+    while (true) {
+      auto largest     = i;
+      auto const left  = 2 * i + 1;
+      auto const right = left + 1;
+      if (left < summary_.size() && summary_[left]->largest > summary_[largest]->largest) {
+        largest = left;
+      }
+      if (right < summary_.size() && summary_[right]->largest > summary_[largest]->largest) {
+        largest = right;
+      }
+      if (largest == i) { return; }
+      summary_swap(i, largest);
+      i = largest;
+    }
+  }
+
   /**
    * @brief Get an avaible memory block of at least `size` bytes
    *
+   * Only the free list of `stream_event` is locked while searching it. If it has no suitable block,
+   * the global mutex is taken to steal from other streams or to grow the pool.
+   *
    * @param size The number of bytes to allocate
    * @param stream_event The stream and associated event on which the allocation will be used.
+   * @param blocks The free list of `stream_event`. Must not be locked by the caller.
    * @return block_type A block of memory of at least `size` bytes
    */
-  block_type get_block(size_t size, stream_event_pair stream_event)
+  block_type get_block(size_t size, stream_event_pair stream_event, stream_free_list& blocks)
   {
     // Try to find a satisfactory block in free list for the same stream (no sync required)
-    auto iter = stream_free_blocks_.find(stream_event);
-    if (iter != stream_free_blocks_.end()) {
-      block_type b = iter->second.get_block(size);
-      if (b.is_valid()) { return b; }
+    {
+      lock_guard blocks_lock(blocks.mtx);
+      block_type const b = this->underlying().get_block_from_list(blocks.blocks, size);
+      if (b.is_valid()) {
+        wait_for_own_list(blocks, stream_event.stream);
+        update_summary(blocks);
+        return b;
+      }
     }
 
-    free_list& blocks =
-      (iter != stream_free_blocks_.end()) ? iter->second : stream_free_blocks_[stream_event];
+    lock_guard lock(mtx_);
+
+    // Idle streams are swept here since the global mutex is held. `blocks` is pinned by the caller.
+    auto const sweep_interval = stream_sweep_interval_.load(std::memory_order_relaxed);
+    if (sweep_interval != 0 && ++slow_allocation_count_ % sweep_interval == 0) { sweep(); }
 
-    // Try to find an existing block in another stream
     {
-      block_type const b = get_block_from_other_stream(size, stream_event, blocks, false);
-      if (b.is_valid()) return b;
+      read_lock streams_lock(streams_mtx_);
+      lock_guard blocks_lock(blocks.mtx);
+
+      // Another thread may have returned blocks to this stream since the first attempt
+      {
+        block_type const b = this->underlying().get_block_from_list(blocks.blocks, size);
+        if (b.is_valid()) {
+          wait_for_own_list(blocks, stream_event.stream);
+          update_summary(blocks);
+          return b;
+        }
+      }
+
+      // Try to find an existing block in another stream
+      {
+        block_type const b = get_block_from_other_stream(size, blocks, stream_event.stream);
+        if (b.is_valid()) return b;
+      }
+
+      // no large enough blocks available on other streams, so sync and merge until we find one
+      {
+        block_type const b = get_block_by_merging(size, blocks, stream_event.stream);
+        if (b.is_valid()) return b;
+      }
+    }
+
+    log_summary_trace();
+
+    // no large enough blocks available after merging, so grow the pool. The free list is not
+    // locked while allocating from upstream; any extra blocks are added to it afterwards.
+    free_list expanded{};
+    auto const b =
+      this->underlying().expand_pool(size, expanded, cuda_stream_view{stream_event.stream});
+    if (not expanded.is_empty()) {
+      lock_guard blocks_lock(blocks.mtx);
+      blocks.blocks.insert(std::move(expanded));
+      update_summary(blocks);
     }
+    return b;
+  }
 
-    // no large enough blocks available on other streams, so sync and merge until we find one
+  /**
+   * @brief Find a free block of at least `size` bytes in the free list of another stream.
+   *
+   * The summary is used to find the streams with large enough free blocks, so no free list is
+   * searched unless it has one. Free lists whose work has already completed are preferred, since
+   * their blocks can be taken without a wait. Otherwise the stream with the largest free block is
+   * chosen. If a block is found in the free list F of a stream with event E, the allocating stream
+   * is made to wait on E (unless F has completed) and all other blocks in F are moved to `blocks`.
+   * This results in coalescing with other blocks in that free list, hopefully reducing
+   * fragmentation.
+   *
+   * The caller must hold the global mutex, the stream map lock and the mutex of `blocks`, and
+   * `blocks` must not have a block of at least `size` bytes. Other free lists are locked one at a
+   * time.
+   *
+   * @param size The requested size of the allocation.
+   * @param blocks The free list of the allocating stream.
+   * @param stream The allocating stream.
+   * @return A block with non-null pointer and size >= `size`, or a nullptr block if no other
+   *         stream has one.
+   */
+  block_type get_block_from_other_stream(size_t size, stream_free_list& blocks, cudaStream_t stream)
+  {
     {
-      block_type const b = get_block_from_other_stream(size, stream_event, blocks, true);
+      block_type const b = get_block_from_completed_stream(size, blocks, stream);
       if (b.is_valid()) return b;
     }
 
-    log_summary_trace();
+    while (true) {
+      stream_free_list* other{};
+      {
+        lock_guard summary_lock(summary_mtx_);
+        if (summary_.empty() || summary_.front()->largest < size) { return block_type{}; }
+        other = summary_.front();
+      }
+      if (other == &blocks) { return block_type{}; }  // only if largest_block_size() is inexact
 
-    // no large enough blocks available after merging, so grow the pool
-    return this->underlying().expand_pool(size, blocks, cuda_stream_view{stream_event.stream});
+      lock_guard other_lock(other->mtx);
+      // The summary may have changed before `other` was locked, in which case try again
+      block_type const b = this->underlying().get_block_from_list(other->blocks, size);
+      if (b.is_valid()) {
+        RMM_LOG_DEBUG("[A][Stream {:p}][{}B][Taken from stream {:p}]",
+                      fmt::ptr(stream),
+                      size,
+                      fmt::ptr(other->stream_event.stream));
+        merge_lists(blocks, *other, stream);
+        ++steal_count_;
+        return b;
+      }
+      update_summary(*other);
+    }
   }
 
   /**
-   * @brief Find a free block of at least `size` bytes in a `free_list` with a different
-   * stream/event than `stream_event`.
+   * @brief Find a free block of at least `size` bytes in the free list of another stream whose
+   * work has already completed, so that it can be taken without making `stream` wait.
    *
-   * If an appropriate block is found in a free list F associated with event E,
-   * `stream_event.stream` will be made to wait on event E. All other blocks in free list F will be
-   * moved to the free list associated with `stream_event.stream`. This results in coalescing with
-   * other blocks in that free list, hopefully reducing fragmentation.
+   * Candidates are up to `max_steal_candidates` free lists with a large enough block according to
+   * the summary. Each is checked with a non-blocking event query, so lists still in use by work in
+   * flight are skipped. The caller must hold the global mutex, the stream map lock and the mutex of
+   * `blocks`.
    *
    * @param size The requested size of the allocation.
-   * @param stream_event The stream and associated event on which the allocation is being
-   * requested.
-   * @return A block with non-null pointer and size >= `size`, or a nullptr block if none is
-   *         available in `blocks`.
+   * @param blocks The free list of the allocating stream.
+   * @param stream The allocating stream.
+   * @return A block with non-null pointer and size >= `size`, or a nullptr block if no completed
+   *         free list of another stream has one.
    */
-  block_type get_block_from_other_stream(size_t size,
-                                         stream_event_pair stream_event,
-                                         free_list& blocks,
-                                         bool merge_first)
+  block_type get_block_from_completed_stream(size_t size,
+                                             stream_free_list& blocks,
+                                             cudaStream_t stream)
   {
-    for (auto it = stream_free_blocks_.begin(), next_it = it; it != stream_free_blocks_.end();
-         it = next_it) {
-      ++next_it;  // Points to element after `it` to allow erasing `it` in the loop body
-      auto other_event = it->first.event;
-      if (other_event != stream_event.event) {
-        auto other_blocks = it->second;
+    find_steal_candidates(size, blocks);
+    for (auto* other : steal_candidates_) {
+      lock_guard other_lock(other->mtx);
+      if (not has_completed(*other)) { continue; }
+      block_type const b = this->underlying().get_block_from_list(other->blocks, size);
+      if (b.is_valid()) {
+        RMM_LOG_DEBUG("[A][Stream {:p}][{}B][Taken from completed stream {:p}]",
+                      fmt::ptr(stream),
+                      size,
+                      fmt::ptr(other->stream_event.stream));
+        merge_lists(blocks, *other, stream, false);
+        ++steal_count_;
+        ++free_steal_count_;
+        return b;
+      }
+      update_summary(*other);
+    }
+    return block_type{};
+  }
 
-        block_type const b = [&]() {
-          if (merge_first) {
-            merge_lists(stream_event, blocks, other_event, std::move(other_blocks));
+  /**
+   * @brief Fill `steal_candidates_` with up to `max_steal_candidates` free lists of streams other
+   * than that of `blocks` whose largest block is at least `size` bytes.
+   *
+   * The lists with a large enough block form a subtree at the root of the summary, so the walk
+   * only descends into those and visits at most one list more than it collects, however many
+   * streams there are. The caller must hold the global mutex.
+   *
+   * @param size The requested size of the allocation.
+   * @param blocks The free list of the allocating stream.
+   */
+  void find_steal_candidates(size_t size, stream_free_list const& blocks)
+  {
+    steal_candidates_.clear();
+    std::array<std::size_t, max_steal_candidates + 2> pending{};  // summary indices to visit
+    std::size_t num_pending{};
 
-            RMM_LOG_DEBUG("[A][Stream {:p}][{}B][Merged stream {:p}]",
-                          fmt::ptr(stream_event.stream),
-                          size,
-                          fmt::ptr(it->first.stream));
+    lock_guard summary_lock(summary_mtx_);
+    if (summary_.empty() || summary_.front()->largest < size) { return; }
+    pending[num_pending++] = 0;
+    while (num_pending > 0 && steal_candidates_.size() < max_steal_candidates) {
+      auto const i = pending[--num_pending];
+      if (summary_[i] != &blocks) { steal_candidates_.push_back(summary_[i]); }
+      for (auto const child : {2 * i + 2, 2 * i + 1}) {
+        if (child < summary_.size() && summary_[child]->largest >= size) {
+          pending[num_pending++] = child;
+        }
+      }
+    }
+  }
 
-            stream_free_blocks_.erase(it);
+  /**
+   * @brief Merge the free lists of other streams into `blocks` until it has a free block of at
+   * least `size` bytes.
+   *
+   * Used when no single free list has a large enough block, in the hope that merging coalesces
+   * smaller blocks. The caller must hold the global mutex, the stream map lock and the mutex of
+   * `blocks`. Other free lists are locked one at a time. Free lists that are emptied are not
+   * erased.
+   *
+   * @param size The requested size of the allocation.
+   * @param blocks The free list of the allocating stream.
+   * @param stream The allocating stream.
+   * @return A block with non-null pointer and size >= `size`, or a nullptr block if none is
+   *         available after merging all free lists.
+   */
+  block_type get_block_by_merging(size_t size, stream_free_list& blocks, cudaStream_t stream)
+  {
+    for (auto& s : stream_free_blocks_) {
+      auto& other = s.second;
+      if (&other == &blocks) { continue; }
 
-            return blocks.get_block(size);  // get the best fit block in merged lists
-          } else {
-            return other_blocks.get_block(size);  // get the best fit block in other list
-          }
-        }();
+      lock_guard other_lock(other.mtx);
+      if (other.blocks.is_empty()) { continue; }
 
-        if (b.is_valid()) {
-          RMM_LOG_DEBUG((merge_first) ? "[A][Stream {:p}][{}B][Found after merging stream {:p}]"
-                                      : "[A][Stream {:p}][{}B][Taken from stream {:p}]",
-                        fmt::ptr(stream_event.stream),
-                        size,
-                        fmt::ptr(it->first.stream));
+      merge_lists(blocks, other, stream);
 
-          if (not merge_first) {
-            merge_lists(stream_event, blocks, other_event, std::move(other_blocks));
-            stream_free_blocks_.erase(it);
-          }
+      RMM_LOG_DEBUG("[A][Stream {:p}][{}B][Merged stream {:p}]",
+                    fmt::ptr(stream),
+                    size,
+                    fmt::ptr(other.stream_event.stream));
 
-          return b;
-        }
+      // get a block from the merged lists
+      block_type const b = this->underlying().get_block_from_list(blocks.blocks, size);
+      if (b.is_valid()) {
+        RMM_LOG_DEBUG("[A][Stream {:p}][{}B][Found after merging stream {:p}]",
+                      fmt::ptr(stream),
+                      size,
+                      fmt::ptr(other.stream_event.stream));
+        wait_for_own_list(blocks, stream);  // b may have been freed by another stream in a group
+        update_summary(blocks);
+        ++steal_count_;
+        return b;
       }
     }
     return block_type{};
   }
 
-  void merge_lists(stream_event_pair stream_event,
-                   free_list& blocks,
-                   cudaEvent_t other_event,
-                   free_list&& other_blocks)
+  /**
+   * @brief Move all blocks of free list `other` into `blocks`, making `stream`, the allocating
+   * stream of `blocks`, wait on the event(s) of `other`. The caller must hold the mutexes of both
+   * free lists.
+   *
+   * The events of `other` are recorded first if they are not up to date. The blocks merged are only
+   * safe to use on another stream after the wait, so the epoch of `blocks` is advanced too.
+   *
+   * @param wait Whether to wait on `other`. Only false if `has_completed(other)`, in which case the
+   * epoch of `blocks` is not advanced.
+   */
+  void merge_lists(stream_free_list& blocks,
+                   stream_free_list& other,
+                   cudaStream_t stream,
+                   bool wait = true)
   {
     // Since we found a block associated with a different stream, we have to insert a wait
     // on the stream's associated event into the allocating stream.
-    RMM_CUDA_TRY(cudaStreamWaitEvent(stream_event.stream, other_event, 0));
+    if (wait) { wait_for_list(other, stream); }
 
     // Merge the two free lists
-    blocks.insert(std::move(other_blocks));
+    blocks.blocks.insert(std::move(other.blocks));
+    if (wait && not blocks.group_members.empty()) {
+      note_group_free(blocks, blocks.group_members.at(stream));
+    } else if (wait) {
+      ++blocks.epoch;
+      if (blocks.record_eagerly) { RMM_CUDA_TRY(record_event(blocks)); }
+    }
+    update_summary(other);
+    update_summary(blocks);
+    ++merge_count_;
+  }
+
+  /**
+   * @brief Returns true if `stream` has its own event and a free list (if any) that is neither
+   * pinned nor shared by a stream group, so that they can be reclaimed. The default stream's free
+   * list is never reclaimed. The caller must hold the stream map lock.
+   */
+  bool is_reclaimable(cudaStream_t stream) const
+  {
+    if (stream == cudaStreamLegacy) { return false; }
+    auto const iter = stream_events_.find(stream);
+    if (iter == stream_events_.end()) { return false; }
+    auto const blocks = stream_free_blocks_.find(iter->second);
+    return blocks == stream_free_blocks_.end() ||
+           (blocks->second.group_members.empty() && blocks->second.pins == 0);
+  }
+
+  /**
+   * @brief Move the blocks in the free list of `stream` to the free list of the default stream,
+   * erase the free list and keep the event of `stream` for reuse.
+   *
+   * The caller must hold the global mutex and the stream map lock exclusively, and `stream` must be
+   * reclaimable.
+   */
+  void reclaim_stream(cudaStream_t stream)
+  {
+    auto const stream_event = stream_events_.at(stream);
+    auto const iter         = stream_free_blocks_.find(stream_event);
+    if (iter != stream_free_blocks_.end()) {
+      auto& blocks = iter->second;
+      auto& target = get_or_add_free_list(get_or_add_event(cudaStreamLegacy));
+      {
+        lock_guard target_lock(target.mtx);
+        lock_guard blocks_lock(blocks.mtx);
+        if (not blocks.blocks.is_empty()) {
+          RMM_LOG_DEBUG("[R][Stream {:p}][Reclaimed into the default stream]", fmt::ptr(stream));
+          wait_for_list(blocks, target.stream_event.stream);
+          target.blocks.insert(std::move(blocks.blocks));
+          ++target.epoch;
+          update_summary(target);
+        }
+      }
+      {
+        lock_guard summary_lock(summary_mtx_);
+        summary_erase(blocks);
+      }
+      stream_free_blocks_.erase(iter);
+    }
+    stream_events_.erase(stream);
+    reclaimed_events_.push_back(stream_event.event);
+    ++reclaim_count_;
+  }
+
+  /**
+   * @brief Reclaim every reclaimable stream whose free list has not been used since the previous
+   * sweep. The caller must hold the global mutex.
+   *
+   * @return std::size_t The number of streams reclaimed.
+   */
+  std::size_t sweep()
+  {
+    write_lock streams_lock(streams_mtx_);
+    std::vector<cudaStream_t> idle;
+    for (auto const& s : stream_events_) {
+      if (not is_reclaimable(s.first)) { continue; }
+      auto const iter = stream_free_blocks_.find(s.second);
+      if (iter == stream_free_blocks_.end() ||
+          iter->second.last_used.load(std::memory_order_relaxed) != sweep_generation_) {
+        idle.push_back(s.first);
+      }
+    }
+    for (auto const stream : idle) {
+      reclaim_stream(stream);
+    }
+    ++sweep_generation_;
+    return idle.size();
   }
 
   /**
@@ -424,42 +1763,52 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
   void release()
   {
     lock_guard lock(mtx_);
+    write_lock streams_lock(streams_mtx_);
 
+    // The streams of a group share the event of its first stream in stream_events_
+    std::set<cudaEvent_t> group_events;
+    for (auto const& s : stream_free_blocks_) {
+      for (auto const& m : s.second.group_members) {
+        RMM_ASSERT_CUDA_SUCCESS(StreamBackend::synchronize_event(m.second.event));
+        RMM_ASSERT_CUDA_SUCCESS(StreamBackend::destroy_event(m.second.event));
+        group_events.insert(m.second.event);
+      }
+    }
     for (auto s_e : stream_events_) {
-      RMM_ASSERT_CUDA_SUCCESS(cudaEventSynchronize(s_e.second.event));
-      RMM_ASSERT_CUDA_SUCCESS(cudaEventDestroy(s_e.second.event));
+      if (group_events.find(s_e.second.event) != group_events.end()) { continue; }
+      RMM_ASSERT_CUDA_SUCCESS(StreamBackend::synchronize_event(s_e.second.event));
+      RMM_ASSERT_CUDA_SUCCESS(StreamBackend::destroy_event(s_e.second.event));
+    }
+    for (auto event : reclaimed_events_) {
+      RMM_ASSERT_CUDA_SUCCESS(StreamBackend::destroy_event(event));
     }
+    reclaimed_events_.clear();
 
     stream_events_.clear();
+    {
+      lock_guard summary_lock(summary_mtx_);
+      summary_.clear();
+    }
     stream_free_blocks_.clear();
   }
 
+  /**
+   * @brief Log the largest free block and the total free bytes at TRACE level.
+   *
+   * Both are read from `free_summary()`, so no free list is visited or locked.
+   */
   void log_summary_trace()
   {
 #if (SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE)
-    std::size_t num_blocks{0};
-    std::size_t max_block{0};
-    std::size_t free_mem{0};
-    std::for_each(stream_free_blocks_.cbegin(),
-                  stream_free_blocks_.cend(),
-                  [this, &num_blocks, &max_block, &free_mem](auto const& freelist) {
-                    num_blocks += freelist.second.size();
-                    auto summary = this->underlying().free_list_summary(freelist.second);
-                    max_block    = std::max(summary.first, max_block);
-                    free_mem += summary.second;
-                  });
-    RMM_LOG_TRACE("[Summary][Free lists: {}][Blocks: {}][Max Block: {}][Total Free: {}]",
-                  stream_free_blocks_.size(),
-                  num_blocks,
-                  max_block,
-                  free_mem);
+    auto const summary = this->underlying().free_summary();
+    RMM_LOG_TRACE("[Summary][Max Block: {}][Total Free: {}]", summary.first, summary.second);
 #endif
   }
 
   // map of stream_event_pair --> free_list
   // Event (or associated stream) must be synced before allocating from associated free_list to a
   // different stream
-  std::map<stream_event_pair, free_list> stream_free_blocks_;
+  std::map<stream_event_pair, stream_free_list> stream_free_blocks_;
 
   // bidirectional mapping between non-default streams and events
   std::unordered_map<cudaStream_t, stream_event_pair> stream_events_;
@@ -468,8 +1817,38 @@ class stream_ordered_memory_resource : public crtp<PoolResource>, public device_
   // or the MR that is using them exists.
   std::set<std::shared_ptr<event_wrapper>> default_stream_events;
 
-  std::mutex mtx_;  // mutex for thread-safe access
-};                  // namespace detail
+  // events of reclaimed streams, to be reused for new streams
+  std::vector<cudaEvent_t> reclaimed_events_;
+
+  // number of sweeps of idle streams. Written with streams_mtx_ held exclusively
+  std::size_t sweep_generation_{};
+
+  // max-heap of free lists ordered by the size of their largest block
+  std::vector<stream_free_list*> summary_;
+
+  mutable std::mutex mtx_;                       // serializes stealing, merging and pool growth
+  mutable std::shared_timed_mutex streams_mtx_;  // guards the stream maps and reclaimed events
+  mutable std::mutex summary_mtx_;               // guards summary_
+
+  std::atomic<std::size_t> steal_count_{};  // allocations satisfied from other streams' free lists
+  std::atomic<std::size_t> free_steal_count_{};  // steals that did not wait on another stream
+  std::atomic<std::size_t> merge_count_{};  // free lists merged into another stream's free list
+  std::atomic<std::size_t> reclaim_count_{};           // streams reclaimed
+  std::atomic<std::size_t> event_record_interval_{1};  // deallocations per event record
+  std::atomic<std::size_t> stream_sweep_interval_{};   // slow-path allocations per sweep
+  std::size_t slow_allocation_count_{};  // allocations that took the global mutex. Guarded by mtx_
+  std::vector<stream_free_list*> steal_candidates_;  // scratch space. Guarded by mtx_
+
+  // Thread caches of freed blocks. Caches are registered so that they can be detached when this
+  // resource is destroyed.
+  std::atomic<std::size_t> thread_cache_size_{};  // maximum bytes per thread, 0 to disable
+  std::atomic<bool> thread_caches_used_{false};   // whether caching has ever been enabled
+  mutable std::mutex thread_caches_mtx_;
+  std::vector<std::shared_ptr<thread_cache>> thread_caches_;  // guarded by thread_caches_mtx_
+  std::size_t retired_thread_cache_hits_{};  // of exited threads. Guarded by thread_caches_mtx_
+
+  std::size_t stream_destruction_callback_id_;  // identifies on_stream_destroyed, 0 once stopped
+};  // namespace detail
 
 }  // namespace detail
 }  // namespace mr
@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/free_list.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+
+namespace rmm {
+namespace mr {
+namespace detail {
+
+/**
+ * @brief A coalescing free list using two-level segregated fit (TLSF).
+ *
+ * Free blocks are segregated into size classes. The first level divides sizes into power-of-two
+ * ranges, and the second level divides each first-level range linearly into `sl_count` classes.
+ * A bitmap for each level records which classes are non-empty, so finding a non-empty class large
+ * enough for a request takes a constant number of bit operations, independent of the number of
+ * free blocks or of how fragmented they are.
+ *
+ * As in TLSF, the search rounds the request up to the next class boundary so that any block of the
+ * class found is large enough ("good fit" rather than best fit). Only if that fails is the class
+ * containing the request itself searched linearly, so that a block of exactly the requested size
+ * is never missed.
+ *
+ * Blocks cannot carry boundary tags (the memory they describe may not be host accessible), so
+ * neighbors for coalescing are found with hash maps keyed by block start and end address, making
+ * insertion expected O(1).
+ *
+ * \see Masmano, M., Ripoll, I., Crespo, A., & Real, J. (2004). TLSF: A new dynamic memory
+ * allocator for real-time systems. In Proc. of the 16th Euromicro Conference on Real-Time Systems
+ * (pp. 79-88). IEEE.
+ */
+struct tlsf_free_list : free_list<block> {
+  /// log2 of the number of second-level classes per first-level class.
+  static constexpr std::size_t sl_index_log2 = 5;
+  /// The number of second-level classes per first-level class.
+  static constexpr std::size_t sl_count = std::size_t{1} << sl_index_log2;
+  /// The number of first-level classes. Class 0 holds all sizes smaller than `sl_count`.
+  static constexpr std::size_t fl_count =
+    std::numeric_limits<std::size_t>::digits - sl_index_log2 + 1;
+
+  tlsf_free_list()  = default;
+  ~tlsf_free_list() = default;
+
+  /// The indices contain iterators into the list, so copies and moves rebuild them.
+  tlsf_free_list(tlsf_free_list const& other) : free_list{} { insert_all(other); }
+  tlsf_free_list(tlsf_free_list&& other) : free_list{}
+  {
+    insert_all(other);
+    other.clear();
+  }
+  tlsf_free_list& operator=(tlsf_free_list const& other)
+  {
+    if (this != &other) {
+      clear();
+      insert_all(other);
+    }
+    return *this;
+  }
+  tlsf_free_list& operator=(tlsf_free_list&& other)
+  {
+    if (this != &other) {
+      clear();
+      insert_all(other);
+      other.clear();
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Inserts a block into the `free_list`, coalescing it with the preceding and following
+   *        blocks if either is contiguous.
+   *
+   * @param b The block to insert.
+   */
+  void insert(block_type const& b)
+  {
+    block_type merged = b;
+
+    // The merged block is larger than the blocks it absorbs, so add() keeps the largest size exact
+    if (not b.is_head()) {
+      auto const previous = by_end_.find(b.pointer());
+      if (previous != by_end_.end()) {
+        merged = previous->second->merge(merged);
+        remove(previous->second);
+      }
+    }
+
+    auto const next = by_start_.find(b.pointer() + b.size());
+    if (next != by_start_.end() && merged.is_contiguous_before(*next->second)) {
+      merged = merged.merge(*next->second);
+      remove(next->second);
+    }
+
+    add(merged);
+  }
+
+  /**
+   * @brief Moves blocks from free_list `other` into this free_list, coalescing them with their
+   *        preceding and following blocks if they are contiguous.
+   *
+   * @param other The free_list to insert into this one.
+   */
+  void insert(tlsf_free_list&& other)
+  {
+    insert_all(other);
+    other.clear();
+  }
+
+  /**
+   * @brief Finds a block in the `free_list` large enough to fit `size` bytes.
+   *
+   * This is a "good fit" search that takes constant time unless the only blocks large enough are
+   * in the same class as `size`.
+   *
+   * @param size The size in bytes of the desired block.
+   * @return block A block large enough to store `size` bytes.
+   */
+  block_type get_block(size_t size)
+  {
+    std::size_t fl{}, sl{};
+    if (find_suitable_class(size, fl, sl)) {
+      block_type const found = *classes_[fl][sl];
+      erase(classes_[fl][sl]);
+      return found;
+    }
+
+    // The rounded-up search can miss blocks in the request's own class, so check that class.
+    mapping_insert(size, fl, sl);
+    if (is_class_empty(fl, sl)) { return block_type{}; }
+    for (auto iter = classes_[fl][sl]; iter != cend() && is_in_class(*iter, fl, sl); ++iter) {
+      if (iter->fits(size)) {
+        block_type const found = *iter;
+        erase(iter);
+        return found;
+      }
+    }
+
+    return block_type{};  // not found
+  }
+
+  /**
+   * @brief Returns the size of the largest block in the free list, or 0 if it is empty.
+   *
+   * The size is maintained as blocks are inserted and erased, so this takes constant time.
+   *
+   * @return std::size_t The size in bytes of the largest block.
+   */
+  std::size_t largest_block_size() const noexcept { return largest_; }
+
+  /**
+   * @brief Removes the block indicated by `iter` from the free list.
+   *
+   * Takes constant time, except that if the block is the largest, the blocks of the largest
+   * non-empty class are searched for the next largest.
+   *
+   * @param iter An iterator referring to the block to erase.
+   */
+  void erase(const_iterator iter)
+  {
+    auto const erased_size = iter->size();
+    remove(iter);
+    if (erased_size == largest_) { update_largest(); }
+  }
+
+  /**
+   * @brief Erase all blocks from the free_list.
+   */
+  void clear() noexcept
+  {
+    fl_bitmap_ = 0;
+    sl_bitmaps_.fill(0);
+    by_start_.clear();
+    by_end_.clear();
+    largest_ = 0;
+    free_list::clear();
+  }
+
+  /**
+   * @brief Print all blocks in the free_list.
+   */
+  void print() const
+  {
+    std::cout << size() << '\n';
+    std::for_each(cbegin(), cend(), [](auto const iter) { iter.print(); });
+  }
+
+ private:
+  /// Removes the block indicated by `iter`, without updating the largest block size.
+  void remove(const_iterator iter)
+  {
+    std::size_t fl{}, sl{};
+    mapping_insert(iter->size(), fl, sl);
+
+    // The blocks of a class are contiguous in the list, starting at classes_[fl][sl]
+    if (iter == classes_[fl][sl]) {
+      auto const next = std::next(iter);
+      if (next != cend() && is_in_class(*next, fl, sl)) {
+        classes_[fl][sl] = next;
+      } else {
+        sl_bitmaps_[fl] &= ~(std::uint32_t{1} << sl);
+        if (sl_bitmaps_[fl] == 0) { fl_bitmap_ &= ~(std::uint64_t{1} << fl); }
+      }
+    }
+
+    by_start_.erase(iter->pointer());
+    by_end_.erase(iter->pointer() + iter->size());
+    free_list::erase(iter);
+  }
+
+  /// Finds the largest block, which is in the largest non-empty class, by searching that class.
+  void update_largest() noexcept
+  {
+    largest_ = 0;
+    if (fl_bitmap_ == 0) { return; }
+    auto const fl = msb(fl_bitmap_);
+    auto const sl = msb(sl_bitmaps_[fl]);
+    for (auto iter = classes_[fl][sl]; iter != cend() && is_in_class(*iter, fl, sl); ++iter) {
+      largest_ = std::max(largest_, iter->size());
+    }
+  }
+
+  /// Adds block `b`, which must not be contiguous with any block in the list.
+  void add(block_type const& b)
+  {
+    std::size_t fl{}, sl{};
+    mapping_insert(b.size(), fl, sl);
+
+    auto const position = is_class_empty(fl, sl) ? cend() : classes_[fl][sl];
+    auto const iter     = get_list().insert(position, b);
+    classes_[fl][sl]    = iter;
+    sl_bitmaps_[fl] |= std::uint32_t{1} << sl;
+    fl_bitmap_ |= std::uint64_t{1} << fl;
+
+    by_start_.emplace(b.pointer(), iter);
+    by_end_.emplace(b.pointer() + b.size(), iter);
+    largest_ = std::max(largest_, b.size());
+  }
+
+  void insert_all(tlsf_free_list const& other)
+  {
+    std::for_each(other.cbegin(), other.cend(), [this](block_type const& b) { this->insert(b); });
+  }
+
+  /// Index of the most significant set bit of `v`, which must be non-zero.
+  static std::size_t msb(std::size_t v) noexcept
+  {
+    return std::numeric_limits<unsigned long long>::digits - 1 - __builtin_clzll(v);
+  }
+
+  /// Computes the class (fl, sl) of blocks of `size` bytes.
+  static void mapping_insert(std::size_t size, std::size_t& fl, std::size_t& sl) noexcept
+  {
+    if (size < sl_count) {
+      fl = 0;
+      sl = size;
+    } else {
+      auto const m = msb(size);
+      sl           = (size >> (m - sl_index_log2)) ^ sl_count;
+      fl           = m - sl_index_log2 + 1;
+    }
+  }
+
+  bool is_class_empty(std::size_t fl, std::size_t sl) const noexcept
+  {
+    return (sl_bitmaps_[fl] & (std::uint32_t{1} << sl)) == 0;
+  }
+
+  static bool is_in_class(block_type const& b, std::size_t fl, std::size_t sl) noexcept
+  {
+    std::size_t b_fl{}, b_sl{};
+    mapping_insert(b.size(), b_fl, b_sl);
+    return b_fl == fl && b_sl == sl;
+  }
+
+  /**
+   * @brief Finds the smallest non-empty class whose blocks are all at least `size` bytes.
+   *
+   * @return true if such a class exists, in which case it is returned in `fl` and `sl`.
+   */
+  bool find_suitable_class(std::size_t size, std::size_t& fl, std::size_t& sl) const noexcept
+  {
+    if (size >= sl_count) {
+      auto const round = (std::size_t{1} << (msb(size) - sl_index_log2)) - 1;
+      if (size > std::numeric_limits<std::size_t>::max() - round) { return false; }
+      size += round;
+    }
+    mapping_insert(size, fl, sl);
+
+    auto sl_map = sl_bitmaps_[fl] & (~std::uint32_t{0} << sl);
+    if (sl_map == 0) {
+      auto const fl_map = (fl + 1 < fl_count) ? fl_bitmap_ & (~std::uint64_t{0} << (fl + 1)) : 0;
+      if (fl_map == 0) { return false; }
+      fl     = __builtin_ctzll(fl_map);
+      sl_map = sl_bitmaps_[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+    return true;
+  }
+
+  std::uint64_t fl_bitmap_{};                         // bit i set if any class (i, *) non-empty
+  std::array<std::uint32_t, fl_count> sl_bitmaps_{};  // bit j of [i] set if class (i, j) non-empty
+  std::array<std::array<const_iterator, sl_count>, fl_count> classes_{};  // first block of class
+  std::unordered_map<char const*, const_iterator> by_start_;  // blocks by start address
+  std::unordered_map<char const*, const_iterator> by_end_;    // blocks by end address
+  std::size_t largest_{};  // size of the largest block, or 0 if the list is empty
+};  // tlsf_free_list
+
+}  // namespace detail
+}  // namespace mr
+}  // namespace rmm
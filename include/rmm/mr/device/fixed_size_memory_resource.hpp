@@ -84,7 +84,12 @@ class fixed_size_memory_resource
    * @brief Destroy the `fixed_size_memory_resource` and free all memory allocated from upstream.
    *
    */
-  ~fixed_size_memory_resource() { release(); }
+  ~fixed_size_memory_resource()
+  {
+    this->stop_stream_destruction_callback();
+    this->detach_thread_caches();
+    release();
+  }
 
   fixed_size_memory_resource()                                  = delete;
   fixed_size_memory_resource(fixed_size_memory_resource const&) = delete;
@@ -252,17 +257,32 @@ class fixed_size_memory_resource
   }
 
   /**
-   * @brief Get the largest available block size and total free size in the specified free list
+   * @brief Get the largest available block size and total free size over all free lists
    *
    * This is intended only for debugging
    *
-   * @param blocks The free list from which to return the summary
    * @return std::pair<std::size_t, std::size_t> Pair of largest available block, total free size
    */
-  std::pair<std::size_t, std::size_t> free_list_summary(free_list const& blocks)
+  std::pair<std::size_t, std::size_t> free_summary() const
+  {
+    std::size_t num_blocks{0};
+    this->for_each_free_list(
+      [&num_blocks](auto const&, free_list const& blocks) { num_blocks += blocks.size(); });
+    return (num_blocks == 0) ? std::make_pair(std::size_t{0}, std::size_t{0})
+                             : std::make_pair(block_size_, num_blocks * block_size_);
+  }
+
+  /**
+   * @brief Get the size of the largest block in free list `blocks`.
+   *
+   * All blocks are `block_size_` bytes, which the free list does not record.
+   *
+   * @param blocks The free list.
+   * @return std::size_t `block_size_`, or 0 if `blocks` is empty.
+   */
+  std::size_t largest_block_size(free_list const& blocks) const
   {
-    return blocks.is_empty() ? std::make_pair(std::size_t{0}, std::size_t{0})
-                             : std::make_pair(block_size_, blocks.size() * block_size_);
+    return blocks.is_empty() ? 0 : block_size_;
   }
 
   Upstream* upstream_mr_;  // The resource from which to allocate new blocks
@@ -265,7 +265,7 @@ auto make_owning_wrapper(std::tuple<std::shared_ptr<Upstreams>...> upstreams, Ar
  * @param args Function parameter pack of arguments to forward to the wrapped resource's constructor
  * @return An `owning_wrapper` wrapping a newly construct `Resource<Upstream>` and `upstream`.
  */
-template <template <typename> class Resource, typename Upstream, typename... Args>
+template <template <typename...> class Resource, typename Upstream, typename... Args>
 auto make_owning_wrapper(std::shared_ptr<Upstream> upstream, Args&&... args)
 {
   return make_owning_wrapper<Resource>(std::make_tuple(std::move(upstream)),
@@ -19,7 +19,10 @@
 #include <rmm/detail/aligned.hpp>
 #include <rmm/detail/error.hpp>
 #include <rmm/logger.hpp>
+#include <rmm/mr/device/detail/block_hash_set.hpp>
 #include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/cuda_stream_backend.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
 #include <rmm/mr/device/detail/stream_ordered_memory_resource.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 
@@ -30,14 +33,20 @@
 #include <cuda_runtime_api.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <numeric>
-#include <set>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace rmm {
@@ -52,6 +61,201 @@ inline std::pair<std::size_t, std::size_t> available_device_memory()
 }
 }  // namespace detail
 
+/**
+ * @brief Determines how many bytes a `pool_memory_resource` requests from its upstream resource
+ * when it must grow to satisfy an allocation.
+ *
+ * Whatever the policy, an expansion is never smaller than the allocation that requires it, and is
+ * clamped so that the pool does not exceed its maximum size (if set).
+ */
+class pool_growth_policy {
+ public:
+  /// The available growth policies
+  enum class kind {
+    geometric,    ///< Double the pool, or grow halfway to the maximum pool size if it is set
+    fixed_chunk,  ///< Grow by the smallest multiple of a fixed chunk size
+    exact_fit,    ///< Grow by exactly the size of the allocation
+    hinted        ///< Grow to an expected peak pool size at once, then geometrically
+  };
+
+  /**
+   * @brief Grow by the current pool size (i.e. double the pool) if the maximum pool size is not
+   * set, otherwise by half the difference between the maximum and current pool sizes.
+   *
+   * This is the default policy.
+   */
+  static pool_growth_policy geometric() noexcept { return pool_growth_policy{kind::geometric, 0}; }
+
+  /**
+   * @brief Grow by the smallest multiple of `chunk_size` bytes large enough for the allocation.
+   *
+   * @throws rmm::logic_error if `chunk_size` is zero or not a multiple of 256 bytes.
+   *
+   * @param chunk_size The size in bytes of each chunk.
+   */
+  static pool_growth_policy fixed_chunk(std::size_t chunk_size)
+  {
+    RMM_EXPECTS(chunk_size > 0 && rmm::detail::is_aligned(chunk_size, alignment),
+                "Error, chunk size required to be a non-zero multiple of 256 bytes");
+    return pool_growth_policy{kind::fixed_chunk, chunk_size};
+  }
+
+  /**
+   * @brief Grow by exactly the (aligned) size of the allocation that requires it.
+   */
+  static pool_growth_policy exact_fit() noexcept { return pool_growth_policy{kind::exact_fit, 0}; }
+
+  /**
+   * @brief Grow the pool to `expected_peak` bytes in a single expansion. Once the pool is that
+   * large, grow geometrically.
+   *
+   * @param expected_peak The expected peak size in bytes of the pool. Rounded up to a multiple of
+   * 256 bytes.
+   */
+  static pool_growth_policy hinted(std::size_t expected_peak) noexcept
+  {
+    return pool_growth_policy{kind::hinted, rmm::detail::align_up(expected_peak, alignment)};
+  }
+
+  /// Returns the kind of this policy.
+  kind get_kind() const noexcept { return kind_; }
+
+  /**
+   * @brief Computes the number of bytes to request from upstream.
+   *
+   * @param size The size in bytes of the allocation that requires the pool to grow.
+   * @param pool_size The current size in bytes of the pool.
+   * @param maximum_pool_size The maximum size in bytes of the pool, if any.
+   * @return std::size_t The number of bytes to grow the pool by, or 0 if growing by `size` bytes
+   * would exceed `maximum_pool_size`.
+   */
+  std::size_t size_to_grow(std::size_t size,
+                           std::size_t pool_size,
+                           thrust::optional<std::size_t> maximum_pool_size) const noexcept
+  {
+    auto const aligned_size = rmm::detail::align_up(size, alignment);
+    auto const remaining =
+      maximum_pool_size.has_value()
+        ? rmm::detail::align_up(maximum_pool_size.value() - pool_size, alignment)
+        : std::numeric_limits<std::size_t>::max();
+    if (aligned_size > remaining) { return 0; }
+
+    auto const geometric_size = [&]() {
+      return maximum_pool_size.has_value() ? std::max(aligned_size, remaining / 2)
+                                           : std::max(aligned_size, pool_size);
+    };
+
+    auto const grow_size = [&]() {
+      switch (kind_) {
+        case kind::fixed_chunk:
+          return (aligned_size / param_ + ((aligned_size % param_ != 0) ? 1 : 0)) * param_;
+        case kind::exact_fit: return aligned_size;
+        case kind::hinted:
+          return (pool_size < param_) ? std::max(aligned_size, param_ - pool_size)
+                                      : geometric_size();
+        default: return geometric_size();
+      }
+    }();
+    return std::min(grow_size, remaining);
+  }
+
+ private:
+  static constexpr std::size_t alignment = 256;
+
+  pool_growth_policy(kind k, std::size_t param) noexcept : kind_{k}, param_{param} {}
+
+  kind kind_;          // the growth policy
+  std::size_t param_;  // chunk size for fixed_chunk, expected peak for hinted, otherwise unused
+};
+
+/**
+ * @brief Determines where in its free memory a `pool_memory_resource` places allocations.
+ *
+ * With the default best-fit policy, an allocation takes the smallest free block large enough for
+ * it, so long-lived large allocations end up interleaved with short-lived small ones and pin the
+ * pool's free memory into fragments. With the dual-ended policy, small allocations are placed at
+ * the bottom of the lowest-addressed free block that fits and large allocations at the top of the
+ * highest-addressed free block that fits, so that within each upstream block the two grow toward
+ * each other and the free memory between them stays contiguous. Dual-ended placement searches the
+ * free list in address order, which takes O(n) time in the number of free blocks.
+ */
+class pool_placement_policy {
+ public:
+  /// The available placement policies
+  enum class kind {
+    best_fit,   ///< Take the smallest free block that fits
+    dual_ended  ///< Small allocations from the lowest addresses, large from the highest
+  };
+
+  /**
+   * @brief Take the smallest free block large enough for the allocation.
+   *
+   * This is the default policy.
+   */
+  static pool_placement_policy best_fit() noexcept
+  {
+    return pool_placement_policy{kind::best_fit, 0};
+  }
+
+  /**
+   * @brief Place allocations smaller than `large_size` bytes at the lowest address, and larger
+   * allocations at the highest address, that fits them.
+   *
+   * @throws rmm::logic_error if `large_size` is zero.
+   *
+   * @param large_size The size in bytes from which an allocation is placed at the top.
+   */
+  static pool_placement_policy dual_ended(std::size_t large_size)
+  {
+    RMM_EXPECTS(large_size > 0, "Error, large allocation size required to be non-zero");
+    return pool_placement_policy{kind::dual_ended, large_size};
+  }
+
+  /// Returns the kind of this policy.
+  kind get_kind() const noexcept { return kind_; }
+
+  /// Returns the size in bytes from which allocations are placed at the top, or 0 for best fit.
+  std::size_t get_large_size() const noexcept { return large_size_; }
+
+  /**
+   * @brief Returns true if an allocation of `size` bytes is placed at the top of its block.
+   *
+   * @param size The (aligned) size in bytes of the allocation.
+   */
+  bool is_placed_at_top(std::size_t size) const noexcept
+  {
+    return kind_ == kind::dual_ended && size >= large_size_;
+  }
+
+ private:
+  pool_placement_policy(kind k, std::size_t large_size) noexcept
+    : kind_{k}, large_size_{large_size}
+  {
+  }
+
+  kind kind_;               // the placement policy
+  std::size_t large_size_;  // allocations at least this large go to the top for dual_ended
+};
+
+namespace detail {
+
+/**
+ * @brief Whether free list type `FreeList` can be searched in address order, as required by
+ * `pool_placement_policy::dual_ended()`.
+ */
+template <typename FreeList, typename = void>
+struct supports_address_placement : std::false_type {
+};
+
+template <typename FreeList>
+struct supports_address_placement<FreeList,
+                                  decltype(std::declval<FreeList&>().get_lowest_block(0),
+                                           std::declval<FreeList&>().get_highest_block(0),
+                                           void())> : std::true_type {
+};
+
+}  // namespace detail
+
 /**
  * @brief A coalescing best-fit suballocator which uses a pool of memory allocated from
  *        an upstream memory_resource.
@@ -59,19 +263,43 @@ inline std::pair<std::size_t, std::size_t> available_device_memory()
  * Allocation (do_allocate()) and deallocation (do_deallocate()) are thread-safe. Also,
  * this class is compatible with CUDA per-thread default stream.
  *
+ * When the pool has no free block large enough for an allocation, the allocating thread grows it
+ * from upstream, which can take much longer than an allocation from the pool. For latency-critical
+ * use, `set_background_refill()` starts a thread that grows the pool ahead of demand instead.
+ *
+ * Allocations larger than the threshold set by `set_large_allocation_threshold()` bypass the pool,
+ * so that they neither fragment it nor grow it.
+ *
+ * By default allocations are placed best fit. `set_placement_policy()` selects dual-ended
+ * placement instead, which keeps large and small allocations apart (see `pool_placement_policy`).
+ *
  * @tparam UpstreamResource memory_resource to use for allocating the pool. Implements
  *                          rmm::mr::device_memory_resource interface.
+ * @tparam FreeListType The type of free list used to manage free blocks in the pool. Must be a
+ *                      coalescing free list of `detail::block`s, e.g. `detail::indexed_free_list`
+ *                      (the default), `detail::coalescing_free_list`, or
+ *                      `detail::deferred_coalescing_free_list` to reuse recently freed blocks
+ *                      before coalescing them.
+ * @tparam StreamBackend The implementation of the stream and event operations used to order reuse
+ *                       of memory across streams: `detail::cuda_stream_backend` (the default), or
+ *                       `detail::host_stream_backend` to simulate streams on the host.
  */
-template <typename Upstream>
+template <typename Upstream,
+          typename FreeListType  = detail::indexed_free_list,
+          typename StreamBackend = detail::cuda_stream_backend>
 class pool_memory_resource final
-  : public detail::stream_ordered_memory_resource<pool_memory_resource<Upstream>,
-                                                  detail::coalescing_free_list> {
+  : public detail::stream_ordered_memory_resource<
+      pool_memory_resource<Upstream, FreeListType, StreamBackend>,
+      FreeListType,
+      StreamBackend> {
  public:
   // TODO use rmm-level def of this.
   static constexpr size_t allocation_alignment = 256;
 
-  friend class detail::stream_ordered_memory_resource<pool_memory_resource<Upstream>,
-                                                      detail::coalescing_free_list>;
+  friend class detail::stream_ordered_memory_resource<
+    pool_memory_resource<Upstream, FreeListType, StreamBackend>,
+    FreeListType,
+    StreamBackend>;
 
   /**
    * @brief Construct a `pool_memory_resource` and allocate the initial device memory pool using
@@ -88,14 +316,19 @@ class pool_memory_resource final
    * available memory on the current device.
    * @param maximum_pool_size Maximum size, in bytes, that the pool can grow to. Defaults to all
    * of the available memory on the current device.
+   * @param growth_policy Determines how much memory to allocate from `upstream_mr` when the pool
+   * must grow. Defaults to `pool_growth_policy::geometric()`.
    */
-  explicit pool_memory_resource(Upstream* upstream_mr,
-                                thrust::optional<std::size_t> initial_pool_size = thrust::nullopt,
-                                thrust::optional<std::size_t> maximum_pool_size = thrust::nullopt)
+  explicit pool_memory_resource(
+    Upstream* upstream_mr,
+    thrust::optional<std::size_t> initial_pool_size = thrust::nullopt,
+    thrust::optional<std::size_t> maximum_pool_size = thrust::nullopt,
+    pool_growth_policy growth_policy                = pool_growth_policy::geometric())
     : upstream_mr_{[upstream_mr]() {
         RMM_EXPECTS(nullptr != upstream_mr, "Unexpected null upstream pointer.");
         return upstream_mr;
-      }()}
+      }()},
+      growth_policy_{growth_policy}
   {
     RMM_EXPECTS(rmm::detail::is_aligned(initial_pool_size.value_or(0), allocation_alignment),
                 "Error, Initial pool size required to be a multiple of 256 bytes");
@@ -109,7 +342,13 @@ class pool_memory_resource final
    * @brief Destroy the `pool_memory_resource` and deallocate all memory it allocated using
    * the upstream resource.
    */
-  ~pool_memory_resource() { release(); }
+  ~pool_memory_resource()
+  {
+    this->stop_stream_destruction_callback();
+    stop_background_refill();
+    this->detach_thread_caches();
+    release();
+  }
 
   pool_memory_resource()                            = delete;
   pool_memory_resource(pool_memory_resource const&) = delete;
@@ -128,9 +367,344 @@ class pool_memory_resource final
   /**
    * @brief Query whether the resource supports the get_mem_info API.
    *
-   * @return bool false
+   * @return bool true
+   */
+  bool supports_get_mem_info() const noexcept override { return true; }
+
+  /**
+   * @brief Computes the size of the current pool
+   *
+   * Includes allocated as well as free memory.
+   *
+   * @return size_t The total size of the currently allocated pool.
+   */
+  size_t pool_size() const noexcept { return current_pool_size_; }
+
+  /**
+   * @brief Get the number of bytes currently allocated from the pool.
+   *
+   * Sizes are counted after alignment to `allocation_alignment` bytes, plus any tail padding (see
+   * `set_minimum_split_size()`).
+   *
+   * @return std::size_t The number of bytes allocated.
+   */
+  std::size_t get_allocated_bytes() const noexcept { return allocated_bytes_; }
+
+  /**
+   * @brief Get the number of bytes in the pool that are not allocated, over all streams' free
+   * lists.
+   *
+   * @return std::size_t The number of free bytes in the pool.
+   */
+  std::size_t get_free_bytes() const noexcept
+  {
+    // The counters are read separately, so guard against concurrent updates between the reads
+    auto const allocated = get_allocated_bytes();
+    auto const total     = pool_size();
+    return total - std::min(total, allocated);
+  }
+
+  /**
+   * @brief Get the size of the largest free block in the pool, which is the largest allocation
+   * that can be made without growing the pool.
+   *
+   * Takes constant time: the largest block of each stream's free list is tracked as it changes.
+   *
+   * @return std::size_t The size in bytes of the largest free block.
+   */
+  std::size_t get_largest_free_block() const { return free_summary().first; }
+
+  /**
+   * @brief Returns free memory to the upstream resource until the pool is no larger than
+   * `target_bytes`.
+   *
+   * Only memory that is entirely free can be returned: each block the pool allocated from upstream
+   * is released if none of it is currently allocated (i.e. a free block spans the whole upstream
+   * block). Blocks are released until `pool_size() <= target_bytes` or no more are fully free, so
+   * the pool may remain larger than `target_bytes`. Synchronizes with the event(s) of each stream
+   * or stream group whose free list releases a block.
+   *
+   * @param target_bytes The pool size, in bytes, to trim down to.
+   * @return std::size_t The number of bytes returned to the upstream resource.
+   */
+  std::size_t trim(std::size_t target_bytes)
+  {
+    lock_guard lock(this->get_mutex());
+
+    std::size_t released{0};
+    this->for_each_free_list([this, target_bytes, &released](
+                               auto const&, free_list& blocks, auto const& synchronize) {
+      bool synchronized{false};
+      for (auto iter = blocks.cbegin(); iter != blocks.cend() && pool_size() > target_bytes;) {
+        auto const upstream = upstream_blocks_.find(iter->pointer());
+        if (upstream == upstream_blocks_.end() || upstream->second != iter->size()) {
+          ++iter;
+          continue;
+        }
+
+        // The block may still be in use by work on its stream that preceded its deallocation
+        if (not synchronized) {
+          synchronize();
+          synchronized = true;
+        }
+
+        RMM_LOG_DEBUG("[T][Upstream {}B][{:p}]", upstream->second, fmt::ptr(upstream->first));
+        upstream_mr_->deallocate(upstream->first, upstream->second);
+        current_pool_size_ -= upstream->second;
+        released += upstream->second;
+        upstream_blocks_.erase(upstream);
+
+        auto const next = std::next(iter);
+        blocks.erase(iter);
+        iter = next;
+      }
+    });
+    return released;
+  }
+
+  /**
+   * @brief Returns all entirely free memory to the upstream resource.
+   *
+   * Equivalent to `trim(0)`.
+   *
+   * @return std::size_t The number of bytes returned to the upstream resource.
+   */
+  std::size_t shrink_to_fit() { return trim(0); }
+
+  /**
+   * @brief Set the minimum size of the remainder split off a free block by an allocation.
+   *
+   * When the block chosen for an allocation exceeds the (aligned) allocation size by fewer than
+   * `bytes` bytes, the whole block is allocated rather than leaving a sliver of free memory too
+   * small to be of use that still costs the free lists a block. The tail padding is returned to
+   * the pool with the allocation. With 0 (the default) every remainder is split off.
+   *
+   * @param bytes The minimum remainder size in bytes.
+   */
+  void set_minimum_split_size(std::size_t bytes) noexcept { minimum_split_size_ = bytes; }
+
+  /**
+   * @brief Get the minimum size of the remainder split off a free block by an allocation.
+   *
+   * @return std::size_t The minimum remainder size in bytes.
+   */
+  std::size_t get_minimum_split_size() const noexcept { return minimum_split_size_.load(); }
+
+  /**
+   * @brief Get the number of bytes allocated beyond the aligned sizes of the current allocations
+   * because their remainders were smaller than the minimum split size.
+   *
+   * This is the internal fragmentation caused by the minimum split size. It is included in
+   * `get_allocated_bytes()`.
+   *
+   * @return std::size_t The number of tail padding bytes of current allocations.
+   */
+  std::size_t get_tail_padding_bytes() const noexcept { return tail_padding_bytes_.load(); }
+
+  /**
+   * @brief Get the number of allocations since construction that were given a whole block rather
+   * than split a remainder smaller than the minimum split size off it.
+   *
+   * This is the number of free slivers, i.e. the external fragmentation, avoided by the minimum
+   * split size.
+   *
+   * @return std::size_t The number of splits avoided.
+   */
+  std::size_t get_avoided_split_count() const noexcept { return avoided_split_count_.load(); }
+
+  /**
+   * @brief Set the size above which allocations bypass the pool.
+   *
+   * Allocations of more than `bytes` (aligned) bytes are made directly from the upstream resource
+   * and returned to it when deallocated, unless kept in the large allocation cache (see
+   * `set_large_allocation_cache_size()`). They do not carve holes in the pool that smaller
+   * allocations then fragment, nor grow it. They are not counted in `pool_size()` or
+   * `get_allocated_bytes()`, and not limited by the maximum pool size. With 0 (the default) no
+   * allocations bypass the pool.
+   *
+   * Changing the threshold does not affect existing allocations.
+   *
+   * @param bytes The size in bytes above which allocations bypass the pool, or 0 to disable.
+   */
+  void set_large_allocation_threshold(std::size_t bytes) noexcept
+  {
+    large_allocation_threshold_ = rmm::detail::align_up(bytes, allocation_alignment);
+  }
+
+  /**
+   * @brief Get the size above which allocations bypass the pool.
+   *
+   * @return std::size_t The size in bytes, or 0 if no allocations bypass the pool.
+   */
+  std::size_t get_large_allocation_threshold() const noexcept
+  {
+    return large_allocation_threshold_.load();
+  }
+
+  /**
+   * @brief Set the maximum number of bytes of deallocated large allocations kept for reuse.
+   *
+   * A large allocation that is deallocated is cached rather than returned to upstream if it fits,
+   * evicting the largest cached allocations if needed. A later large allocation of exactly the
+   * same (aligned) size on the same stream reuses it. With 0 (the default) nothing is cached;
+   * lowering the size returns cached allocations to upstream.
+   *
+   * @param bytes The maximum size in bytes of the large allocation cache.
+   */
+  void set_large_allocation_cache_size(std::size_t bytes)
+  {
+    std::vector<large_block> evicted;
+    {
+      lock_guard lock(large_mtx_);
+      large_cache_size_ = bytes;
+      evict_large_blocks(0, evicted);
+    }
+    deallocate_large_blocks(evicted);
+  }
+
+  /**
+   * @brief Get the maximum number of bytes of deallocated large allocations kept for reuse.
+   *
+   * @return std::size_t The maximum size in bytes of the large allocation cache.
+   */
+  std::size_t get_large_allocation_cache_size() const
+  {
+    lock_guard lock(large_mtx_);
+    return large_cache_size_;
+  }
+
+  /**
+   * @brief Get the number of bytes currently allocated directly from upstream because the
+   * allocations exceeded the large allocation threshold.
+   *
+   * @return std::size_t The number of bytes of live large allocations.
+   */
+  std::size_t get_large_allocated_bytes() const noexcept { return large_allocated_bytes_.load(); }
+
+  /**
+   * @brief Get the number of bytes of deallocated large allocations kept for reuse.
+   *
+   * @return std::size_t The number of bytes in the large allocation cache.
+   */
+  std::size_t get_large_cached_bytes() const
+  {
+    lock_guard lock(large_mtx_);
+    return large_cached_bytes_;
+  }
+
+  /**
+   * @brief Get the sizes of the expansions of the pool since construction.
+   *
+   * The initial allocation of the pool is not included.
+   *
+   * @return std::vector<std::size_t> The size in bytes of each upstream allocation made to grow
+   * the pool, in order.
+   */
+  std::vector<std::size_t> get_expansion_sizes() const
+  {
+    lock_guard lock(this->get_mutex());
+    return expansion_sizes_;
+  }
+
+  /**
+   * @brief Keep at least `reserve_bytes` free in the pool by growing it from a background thread
+   * whenever free bytes drop below `low_water_bytes`.
+   *
+   * While the reserve lasts, allocations are satisfied from the pool without calling upstream.
+   * Allocations made faster than the background thread can refill the pool still grow it
+   * themselves (see `get_blocking_expansion_count()`). Each background expansion is added to the
+   * free list of the non-default stream whose allocation last found free bytes below
+   * `low_water_bytes`, so that further allocations on that stream need not take it from another
+   * stream. It goes to the default stream's free list if the refill was triggered on a default
+   * stream, or if the stream has since been destroyed. Background expansions are not limited by
+   * the growth policy, but never grow the pool beyond its maximum size. If an expansion fails it is
+   * retried after the next allocation that finds free bytes below `low_water_bytes`.
+   *
+   * Calling with a `reserve_bytes` of 0 stops background refill. Must not be called concurrently
+   * with itself.
+   *
+   * @throws rmm::logic_error if `low_water_bytes > reserve_bytes`
+   *
+   * @param reserve_bytes The number of free bytes to grow the pool to.
+   * @param low_water_bytes The number of free bytes below which the pool is grown.
+   */
+  void set_background_refill(std::size_t reserve_bytes, std::size_t low_water_bytes)
+  {
+    RMM_EXPECTS(low_water_bytes <= reserve_bytes,
+                "Error, low water mark must not exceed the reserve");
+    stop_background_refill();
+    if (reserve_bytes == 0) { return; }
+
+    refill_reserve_   = rmm::detail::align_up(reserve_bytes, allocation_alignment);
+    refill_low_water_ = low_water_bytes;
+    refill_stop_      = false;
+    refill_requested_ = true;  // the pool may already be below the low water mark
+    refill_thread_    = std::thread{[this]() { refill_loop(); }};
+  }
+
+  /**
+   * @brief Get the number of allocations satisfied without the allocating thread growing the pool.
+   *
+   * @return std::size_t The number of allocations that did not call upstream.
+   */
+  std::size_t get_fast_path_count() const noexcept
+  {
+    return allocation_count_.load() - blocking_expansion_count_.load();
+  }
+
+  /**
+   * @brief Get the number of allocations for which the allocating thread had to grow the pool from
+   * upstream.
+   *
+   * @return std::size_t The number of expansions made by allocating threads.
    */
-  bool supports_get_mem_info() const noexcept override { return false; }
+  std::size_t get_blocking_expansion_count() const noexcept
+  {
+    return blocking_expansion_count_.load();
+  }
+
+  /**
+   * @brief Get the number of expansions made by the background refill thread.
+   *
+   * @return std::size_t The number of background expansions.
+   */
+  std::size_t get_background_expansion_count() const noexcept
+  {
+    return background_expansion_count_.load();
+  }
+
+  /**
+   * @brief Get the policy used to determine how much memory to allocate when the pool grows.
+   *
+   * @return pool_growth_policy The growth policy.
+   */
+  pool_growth_policy get_growth_policy() const noexcept { return growth_policy_; }
+
+  /**
+   * @brief Set the policy that determines where in the pool's free memory allocations are placed.
+   *
+   * The policy applies to subsequent allocations. It must not be changed while other threads
+   * allocate from the pool.
+   *
+   * @throws rmm::logic_error if `policy` is dual-ended and `FreeListType` cannot be searched in
+   * address order, e.g. `detail::tlsf_free_list`.
+   *
+   * @param policy The placement policy.
+   */
+  void set_placement_policy(pool_placement_policy policy)
+  {
+    RMM_EXPECTS(policy.get_kind() == pool_placement_policy::kind::best_fit ||
+                  detail::supports_address_placement<free_list>::value,
+                "Error, dual-ended placement requires an address-ordered free list");
+    placement_policy_ = policy;
+  }
+
+  /**
+   * @brief Get the policy that determines where in the pool's free memory allocations are placed.
+   *
+   * @return pool_placement_policy The placement policy.
+   */
+  pool_placement_policy get_placement_policy() const noexcept { return placement_policy_; }
 
   /**
    * @brief Get the upstream memory_resource object.
@@ -140,12 +714,21 @@ class pool_memory_resource final
   Upstream* get_upstream() const noexcept { return upstream_mr_; }
 
  protected:
-  using free_list  = detail::coalescing_free_list;
-  using block_type = free_list::block_type;
-  using typename detail::stream_ordered_memory_resource<pool_memory_resource<Upstream>,
-                                                        detail::coalescing_free_list>::split_block;
+  using stream_ordered = detail::stream_ordered_memory_resource<
+    pool_memory_resource<Upstream, FreeListType, StreamBackend>,
+    FreeListType,
+    StreamBackend>;
+  using free_list  = FreeListType;
+  using block_type = typename free_list::block_type;
+  using typename detail::stream_ordered_memory_resource<
+    pool_memory_resource<Upstream, FreeListType, StreamBackend>,
+    FreeListType,
+    StreamBackend>::split_block;
   using lock_guard = std::lock_guard<std::mutex>;
 
+  /// The number of independently locked shards of the table of allocated blocks
+  static constexpr std::size_t allocated_block_shards = 16;
+
   /**
    * @brief Get the maximum size of allocations supported by this memory resource
    *
@@ -238,19 +821,275 @@ class pool_memory_resource final
    */
   block_type expand_pool(std::size_t size, free_list& blocks, cuda_stream_view stream)
   {
-    // Strategy: If maximum_pool_size_ is set, then grow geometrically, e.g. by halfway to the
-    // limit each time. If it is not set, grow exponentially, e.g. by doubling the pool size each
-    // time. Upon failure, attempt to back off exponentially, e.g. by half the attempted size,
-    // until either success or the attempt is less than the requested size.
-    return try_to_expand(size_to_grow(size), size, stream);
+    // Strategy: grow by the size computed by the growth policy. Upon failure, attempt to back off
+    // exponentially, e.g. by half the attempted size, until either success or the attempt is less
+    // than the requested size.
+    auto const b = try_to_expand(size_to_grow(size), size, stream);
+    expansion_sizes_.push_back(b.size());
+    ++blocking_expansion_count_;
+    return b;
+  }
+
+  /**
+   * @brief Allocates memory of size at least `bytes`, directly from upstream if it exceeds the
+   * large allocation threshold, otherwise from the pool.
+   *
+   * @throws `std::bad_alloc` if the requested allocation could not be fulfilled
+   *
+   * @param bytes The size in bytes of the allocation
+   * @param stream The stream to associate this allocation with
+   * @return void* Pointer to the newly allocated memory
+   */
+  void* do_allocate(std::size_t bytes, cuda_stream_view stream) override
+  {
+    auto const size      = rmm::detail::align_up(bytes, allocation_alignment);
+    auto const threshold = large_allocation_threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0 || size <= threshold) {
+      void* const p = stream_ordered::do_allocate(bytes, stream);
+      if (get_free_bytes() < refill_low_water_) { request_refill(stream); }
+      return p;
+    }
+    return allocate_large(size, stream);
+  }
+
+  /**
+   * @brief Deallocate memory pointed to by `p`, to upstream or the large allocation cache if it
+   * was a large allocation, otherwise to the pool.
+   *
+   * @param p Pointer to be deallocated
+   * @param bytes The size in bytes of the allocation
+   * @param stream The stream in which to order this deallocation
+   */
+  void do_deallocate(void* p, std::size_t bytes, cuda_stream_view stream) override
+  {
+    // Only allocations at least as large as the smallest live large allocation can be one
+    auto const size = rmm::detail::align_up(bytes, allocation_alignment);
+    if (size < smallest_large_allocation_.load(std::memory_order_relaxed) ||
+        not deallocate_large(p, size, stream)) {
+      stream_ordered::do_deallocate(p, bytes, stream);
+    }
+  }
+
+  /// A large allocation made directly from upstream
+  struct large_block {
+    void* pointer;
+    std::size_t size;
+    cudaStream_t stream;  // on which it was last used, when cached
+  };
+
+  /**
+   * @brief Allocate `size` (aligned) bytes directly from upstream, or reuse a cached large
+   * allocation of the same size last used on `stream`.
+   */
+  void* allocate_large(std::size_t size, cuda_stream_view stream)
+  {
+    void* p{};
+    {
+      lock_guard lock(large_mtx_);
+      auto const range  = large_cache_.equal_range(size);
+      auto const cached = std::find_if(range.first, range.second, [stream](auto const& entry) {
+        return entry.second.stream == stream.value();
+      });
+      if (cached != range.second) {
+        p = cached->second.pointer;
+        large_cached_bytes_ -= size;
+        large_cache_.erase(cached);
+      }
+    }
+
+    if (p == nullptr) {
+      try {
+        p = upstream_mr_->allocate(size, stream);
+      } catch (std::exception const&) {
+        // Cached allocations of other sizes or streams may be what is in the way
+        std::vector<large_block> evicted;
+        {
+          lock_guard lock(large_mtx_);
+          if (large_cache_.empty()) { throw; }
+          evict_large_blocks(large_cached_bytes_, evicted);
+        }
+        deallocate_large_blocks(evicted);
+        p = upstream_mr_->allocate(size, stream);
+      }
+    }
+    RMM_LOG_TRACE("[A][stream {:p}][{}B][{:p}][Large]", fmt::ptr(stream.value()), size, p);
+
+    {
+      lock_guard lock(large_mtx_);
+      large_allocations_.emplace(p, size);
+      ++large_allocation_sizes_[size];
+      update_smallest_large_allocation();
+    }
+    large_allocated_bytes_ += size;
+    return p;
+  }
+
+  /**
+   * @brief If `p` is a large allocation, return it to the large allocation cache or to upstream.
+   *
+   * @return bool true if `p` is a large allocation, false otherwise.
+   */
+  bool deallocate_large(void* p, std::size_t size, cuda_stream_view stream)
+  {
+    std::vector<large_block> evicted;
+    {
+      lock_guard lock(large_mtx_);
+      auto const iter = large_allocations_.find(p);
+      if (iter == large_allocations_.end()) { return false; }
+      RMM_LOGGING_ASSERT(iter->second == size);
+      large_allocations_.erase(iter);
+      large_allocated_bytes_ -= size;
+      auto const count = large_allocation_sizes_.find(size);
+      if (--count->second == 0) {
+        large_allocation_sizes_.erase(count);
+        update_smallest_large_allocation();
+      }
+
+      large_block const b{p, size, stream.value()};
+      if (size <= large_cache_size_) {
+        evict_large_blocks(size, evicted);
+        large_cache_.emplace(size, b);
+        large_cached_bytes_ += size;
+      } else {
+        evicted.push_back(b);
+      }
+    }
+    RMM_LOG_TRACE("[D][stream {:p}][{}B][{:p}][Large]", fmt::ptr(stream.value()), size, p);
+    deallocate_large_blocks(evicted);
+    return true;
+  }
+
+  /**
+   * @brief Set the size below which deallocations skip the lookup of large allocations to the
+   * size of the smallest live large allocation. The caller must hold `large_mtx_`.
+   */
+  void update_smallest_large_allocation() noexcept
+  {
+    smallest_large_allocation_ = large_allocation_sizes_.empty()
+                                   ? std::numeric_limits<std::size_t>::max()
+                                   : large_allocation_sizes_.cbegin()->first;
+  }
+
+  /**
+   * @brief Remove the largest cached large allocations until `size` more bytes fit in the cache,
+   * adding them to `evicted`. The caller must hold `large_mtx_`.
+   */
+  void evict_large_blocks(std::size_t size, std::vector<large_block>& evicted)
+  {
+    while (not large_cache_.empty() && large_cached_bytes_ + size > large_cache_size_) {
+      auto const largest = std::prev(large_cache_.end());
+      evicted.push_back(largest->second);
+      large_cached_bytes_ -= largest->first;
+      large_cache_.erase(largest);
+    }
+  }
+
+  /// Return large allocations to upstream, without holding `large_mtx_`.
+  void deallocate_large_blocks(std::vector<large_block> const& blocks)
+  {
+    for (auto const& b : blocks) {
+      upstream_mr_->deallocate(b.pointer, b.size, b.stream);
+    }
+  }
+
+  /// Stops the background refill thread, if running, and waits for it to exit.
+  void stop_background_refill()
+  {
+    if (not refill_thread_.joinable()) { return; }
+    {
+      lock_guard lock(refill_mtx_);
+      refill_stop_ = true;
+    }
+    refill_cv_.notify_one();
+    refill_thread_.join();
+    refill_low_water_ = 0;
+  }
+
+  /// Wakes the background refill thread, if it is not already awake, when the pool runs low on
+  /// `stream`.
+  void request_refill(cuda_stream_view stream)
+  {
+    refill_stream_ = stream.value();
+    if (refill_requested_.exchange(true)) { return; }
+    // Taking the mutex ensures the thread is either waiting or yet to check the request
+    lock_guard lock(refill_mtx_);
+    refill_cv_.notify_one();
+  }
+
+  void refill_loop()
+  {
+    std::unique_lock<std::mutex> lock(refill_mtx_);
+    while (true) {
+      refill_cv_.wait(lock, [this]() { return refill_stop_ || refill_requested_; });
+      if (refill_stop_) { return; }
+      refill_requested_ = false;
+      lock.unlock();
+      refill();
+      lock.lock();
+    }
+  }
+
+  /**
+   * @brief Grow the pool to `refill_reserve_` free bytes if it is below `refill_low_water_`.
+   *
+   * The global mutex is not held while allocating from upstream, so that allocating threads that
+   * need it to steal or merge blocks are not delayed. The size of the allocation in flight is
+   * counted by `size_to_grow()` so that concurrent expansions respect the maximum pool size.
+   *
+   * The memory is allocated on the default stream, which is synchronized before the memory is
+   * given to another stream. The new block is inserted into a free list before the pool size
+   * grows, so that an allocation that sees the new size finds the block.
+   */
+  void refill()
+  {
+    std::size_t size{};
+    {
+      lock_guard lock(this->get_mutex());
+      auto const free = get_free_bytes();
+      if (free >= refill_low_water_) { return; }
+      auto const remaining = maximum_pool_size_.has_value()
+                               ? maximum_pool_size_.value() - std::min(maximum_pool_size_.value(),
+                                                                       pool_size())
+                               : std::numeric_limits<std::size_t>::max();
+      size = std::min(rmm::detail::align_up(refill_reserve_ - free, allocation_alignment),
+                      remaining);
+      if (size == 0) { return; }
+      refill_in_flight_ = size;
+    }
+
+    auto const stream = refill_stream_.load();
+    auto const to_default =
+      cuda_stream_view{stream}.is_default() || cuda_stream_view{stream}.is_per_thread_default();
+    void* p{};
+    try {
+      p = upstream_mr_->allocate(size, cuda_stream_view{});
+      if (not to_default) {
+        RMM_CUDA_TRY(StreamBackend::synchronize_stream(cuda_stream_view{}.value()));
+      }
+    } catch (std::exception const& e) {
+      if (p != nullptr) { upstream_mr_->deallocate(p, size, cuda_stream_view{}); }
+      p = nullptr;
+      RMM_LOG_WARN("[R][Upstream {}B][Background refill failed: {}]", size, e.what());
+    }
+
+    block_type const b{static_cast<char*>(p), size, true};
+    lock_guard lock(this->get_mutex());
+    refill_in_flight_ = 0;
+    if (p == nullptr) { return; }
+    RMM_LOG_DEBUG("[R][Stream {:p}][Upstream {}B][{:p}]", fmt::ptr(stream), size, fmt::ptr(p));
+    if (to_default || not this->insert_block_if_tracked(b, stream)) {
+      this->insert_block(b, cudaStreamLegacy);
+    }
+    upstream_blocks_.emplace(b.pointer(), b.size());
+    current_pool_size_ += size;
+    expansion_sizes_.push_back(size);
+    ++background_expansion_count_;
   }
 
   /**
    * @brief Given a minimum size, computes an appropriate size to grow the pool.
    *
-   * Strategy is to try to grow the pool by half the difference between the configured maximum
-   * pool size and the current pool size, if the maximum pool size is set. If it is not set, try
-   * to double the current pool size.
+   * The size is determined by the pool's growth policy (see `pool_growth_policy`).
    *
    * Returns 0 if the requested size cannot be satisfied.
    *
@@ -259,13 +1098,7 @@ class pool_memory_resource final
    */
   std::size_t size_to_grow(std::size_t size) const
   {
-    if (maximum_pool_size_.has_value()) {
-      auto const unaligned_remaining = maximum_pool_size_.value() - pool_size();
-      auto const remaining    = rmm::detail::align_up(unaligned_remaining, allocation_alignment);
-      auto const aligned_size = rmm::detail::align_up(size, allocation_alignment);
-      return (aligned_size <= remaining) ? std::max(aligned_size, remaining / 2) : 0;
-    } else
-      return std::max(size, pool_size());
+    return growth_policy_.size_to_grow(size, pool_size() + refill_in_flight_, maximum_pool_size_);
   };
 
   /**
@@ -284,17 +1117,49 @@ class pool_memory_resource final
     try {
       void* p = upstream_mr_->allocate(size, stream);
       block_type b{reinterpret_cast<char*>(p), size, true};
-      upstream_blocks_.emplace_back(b);  // TODO: with C++17 use version that returns a reference
+      upstream_blocks_.emplace(b.pointer(), b.size());
       return thrust::optional<block_type>{b};
     } catch (std::exception const& e) {
       return thrust::nullopt;
     }
   }
 
+  /**
+   * @brief Remove and return a block large enough for `size` bytes from free list `blocks`,
+   * according to the placement policy.
+   *
+   * @param blocks The free list.
+   * @param size The size in bytes of the requested allocation.
+   * @return block_type A block of at least `size` bytes, or an invalid block if there is none.
+   */
+  block_type get_block_from_list(free_list& blocks, size_t size)
+  {
+    return get_placed_block(blocks, size, detail::supports_address_placement<free_list>{});
+  }
+
+  /// Get a block according to the placement policy from an address-ordered free list
+  block_type get_placed_block(free_list& blocks, size_t size, std::true_type)
+  {
+    switch (placement_policy_.get_kind()) {
+      case pool_placement_policy::kind::dual_ended:
+        return placement_policy_.is_placed_at_top(size) ? blocks.get_highest_block(size)
+                                                        : blocks.get_lowest_block(size);
+      default: return blocks.get_block(size);
+    }
+  }
+
+  /// Get a block from a free list that only supports best fit
+  block_type get_placed_block(free_list& blocks, size_t size, std::false_type)
+  {
+    return blocks.get_block(size);
+  }
+
   /**
    * @brief Splits block `b` if necessary to return a pointer to memory of `size` bytes.
    *
-   * If the block is split, the remainder is returned to the pool.
+   * If the block is split, the remainder is returned to the pool. It is not split if the remainder
+   * would be smaller than the minimum split size, in which case the whole block is allocated.
+   * Allocations the placement policy places at the top are taken from the end of the block.
    *
    * @param b The block to allocate from.
    * @param size The size in bytes of the requested allocation.
@@ -304,11 +1169,30 @@ class pool_memory_resource final
    */
   split_block allocate_from_block(block_type const& b, size_t size)
   {
-    block_type const alloc{b.pointer(), size, b.is_head()};
-    allocated_blocks_.insert(alloc);
+    // Rather than leave a sliver, allocate the whole block and remember its size for free_block()
+    auto const padding = b.size() - size;
+    if (padding > 0 && padding < minimum_split_size_.load(std::memory_order_relaxed)) {
+      tail_padding_bytes_ += padding;
+      ++avoided_split_count_;
+      size = b.size();
+    }
 
-    auto rest =
-      (b.size() > size) ? block_type{b.pointer() + size, b.size() - size, false} : block_type{};
+    // With the remainder left below, a top-placed allocation never starts an upstream block
+    bool const at_top = b.size() > size && placement_policy_.is_placed_at_top(size);
+    block_type const alloc =
+      at_top ? block_type{b.pointer() + (b.size() - size), size, false}
+             : block_type{b.pointer(), size, b.is_head()};
+    {
+      auto& shard = get_allocated_block_shard(alloc.pointer());
+      lock_guard lock(shard.mtx);
+      shard.blocks.insert(alloc);
+    }
+    allocated_bytes_ += size;
+    ++allocation_count_;
+
+    auto rest = (b.size() == size) ? block_type{}
+                : at_top           ? block_type{b.pointer(), b.size() - size, b.is_head()}
+                                   : block_type{b.pointer() + size, b.size() - size, false};
     return {reinterpret_cast<void*>(alloc.pointer()), rest};
   }
 
@@ -318,32 +1202,30 @@ class pool_memory_resource final
    * @param p The pointer to the memory to free.
    * @param size The size of the memory to free. Must be equal to the original allocation size.
    * @param stream The stream-event pair for the stream on which the memory was last used.
-   * @return The (now freed) block associated with `p`. The caller is expected to return the block
-   * to the pool.
+   * @return The (now freed) block associated with `p`, including any tail padding. The caller is
+   * expected to return the block to the pool.
    */
   block_type free_block(void* p, size_t size) noexcept
   {
     if (p == nullptr) return block_type{};
 
-    auto const i = allocated_blocks_.find(static_cast<char*>(p));
-    RMM_LOGGING_ASSERT(i != allocated_blocks_.end());
+    auto const block = [p](allocated_block_shard& shard) {
+      lock_guard lock(shard.mtx);
+      auto const i = shard.blocks.find(p);
+      RMM_LOGGING_ASSERT(i != shard.blocks.end());
+      auto const found = *i;
+      shard.blocks.erase(i);
+      return found;
+    }(get_allocated_block_shard(p));
 
-    auto block = *i;
-    RMM_LOGGING_ASSERT(block.size() == rmm::detail::align_up(size, allocation_alignment));
-    allocated_blocks_.erase(i);
+    auto const aligned_size = rmm::detail::align_up(size, allocation_alignment);
+    RMM_LOGGING_ASSERT(block.size() >= aligned_size);
+    tail_padding_bytes_ -= block.size() - aligned_size;
+    allocated_bytes_ -= block.size();
 
     return block;
   }
 
-  /**
-   * @brief Computes the size of the current pool
-   *
-   * Includes allocated as well as free memory.
-   *
-   * @return size_t The total size of the currently allocated pool.
-   */
-  size_t pool_size() const noexcept { return current_pool_size_; }
-
   /**
    * @brief Free all memory allocated from the upstream memory_resource.
    *
@@ -352,12 +1234,29 @@ class pool_memory_resource final
   {
     lock_guard lock(this->get_mutex());
 
-    for (auto b : upstream_blocks_)
-      upstream_mr_->deallocate(b.pointer(), b.size());
+    for (auto const& b : upstream_blocks_)
+      upstream_mr_->deallocate(b.first, b.second);
     upstream_blocks_.clear();
-    allocated_blocks_.clear();
+    for (auto& shard : allocated_blocks_) {
+      lock_guard shard_lock(shard.mtx);
+      shard.blocks.clear();
+    }
 
-    current_pool_size_ = 0;
+    current_pool_size_  = 0;
+    allocated_bytes_    = 0;
+    tail_padding_bytes_ = 0;
+
+    lock_guard large_lock(large_mtx_);
+    for (auto const& a : large_allocations_)
+      upstream_mr_->deallocate(a.first, a.second);
+    large_allocations_.clear();
+    large_allocation_sizes_.clear();
+    update_smallest_large_allocation();
+    for (auto const& c : large_cache_)
+      upstream_mr_->deallocate(c.second.pointer, c.second.size, c.second.stream);
+    large_cache_.clear();
+    large_cached_bytes_    = 0;
+    large_allocated_bytes_ = 0;
   }
 
   /**
@@ -377,62 +1276,118 @@ class pool_memory_resource final
     std::cout << "upstream_blocks: " << upstream_blocks_.size() << "\n";
     std::size_t upstream_total{0};
 
-    for (auto h : upstream_blocks_) {
-      h.print();
-      upstream_total += h.size();
+    for (auto const& h : upstream_blocks_) {
+      block_type{h.first, h.second, true}.print();
+      upstream_total += h.second;
     }
     std::cout << "total upstream: " << upstream_total << " B\n";
 
-    std::cout << "allocated_blocks: " << allocated_blocks_.size() << "\n";
-    for (auto b : allocated_blocks_)
-      b.print();
+    std::size_t num_allocated{0};
+    for (auto& shard : allocated_blocks_) {
+      lock_guard shard_lock(shard.mtx);
+      num_allocated += shard.blocks.size();
+    }
+    std::cout << "allocated_blocks: " << num_allocated << "\n";
+    for (auto& shard : allocated_blocks_) {
+      lock_guard shard_lock(shard.mtx);
+      for (auto b : shard.blocks)
+        b.print();
+    }
 
     this->print_free_blocks();
   }
 
   /**
-   * @brief Get the largest available block size and total free size in the specified free list
+   * @brief Get the largest available block size and total free size over all free lists
    *
-   * This is intended only for debugging
+   * Both are maintained incrementally, so this takes constant time.
    *
-   * @param blocks The free list from which to return the summary
    * @return std::pair<std::size_t, std::size_t> Pair of largest available block, total free size
    */
-  std::pair<std::size_t, std::size_t> free_list_summary(free_list const& blocks)
+  std::pair<std::size_t, std::size_t> free_summary() const
   {
-    std::size_t largest{};
-    std::size_t total{};
-    std::for_each(blocks.cbegin(), blocks.cend(), [&largest, &total](auto const& b) {
-      total += b.size();
-      largest = std::max(largest, b.size());
-    });
-    return {largest, total};
+    return {this->get_largest_free_block_size(), get_free_bytes()};
   }
 
   /**
    * @brief Get free and available memory for memory resource
    *
+   * The free size is the number of bytes in the pool that are not allocated, and the total size
+   * is the size of the pool. Neither includes memory the pool could still allocate from upstream
+   * when it grows. Both are read from counters, without locking or visiting the free lists.
+   *
    * @throws nothing
    *
-   * @param stream to execute on
+   * @param stream to execute on (ignored)
    * @return std::pair contaiing free_size and total_size of memory
    */
-  std::pair<size_t, size_t> do_get_mem_info(cuda_stream_view stream) const override
+  std::pair<size_t, size_t> do_get_mem_info(cuda_stream_view) const override
   {
-    std::size_t free_size{};
-    std::size_t total_size{};
-    // TODO implement this
-    return std::make_pair(free_size, total_size);
+    return std::make_pair(get_free_bytes(), pool_size());
   }
 
   Upstream* upstream_mr_;  // The "heap" to allocate the pool from
-  std::size_t current_pool_size_{};
+  std::atomic<std::size_t> current_pool_size_{};
+  std::atomic<std::size_t> allocated_bytes_{};     // bytes allocated from the pool (aligned sizes)
+  std::atomic<std::size_t> minimum_split_size_{};   // smaller remainders are not split off
+  std::atomic<std::size_t> tail_padding_bytes_{};   // included in allocated_bytes_
+  std::atomic<std::size_t> avoided_split_count_{};  // allocations given a whole block
   thrust::optional<std::size_t> maximum_pool_size_{};
+  pool_growth_policy growth_policy_;
+  pool_placement_policy placement_policy_{pool_placement_policy::best_fit()};
+  std::vector<std::size_t> expansion_sizes_;  // sizes of upstream allocations made to grow the pool
+
+  std::atomic<std::size_t> allocation_count_{};
+  std::atomic<std::size_t> blocking_expansion_count_{};    // expansions by allocating threads
+  std::atomic<std::size_t> background_expansion_count_{};  // expansions by the refill thread
+
+  // Background refill. The reserve and low water mark are only written while no thread runs.
+  std::size_t refill_reserve_{};
+  std::atomic<std::size_t> refill_low_water_{};  // 0 if background refill is not enabled
+  std::size_t refill_in_flight_{};  // bytes being allocated by the refill thread. Guarded by mtx_
+  std::mutex refill_mtx_;
+  std::condition_variable refill_cv_;  // signals refill requests and stopping
+  std::atomic<bool> refill_requested_{false};
+  std::atomic<cudaStream_t> refill_stream_{cudaStreamLegacy};  // the last stream to run low
+  bool refill_stop_{false};  // guarded by refill_mtx_
+  std::thread refill_thread_;
+
+  /**
+   * @brief A shard of the table of allocated blocks and the mutex that guards it.
+   *
+   * Allocation and deallocation on different streams do not take the global mutex, so the table
+   * is split into independently locked shards, selected by pointer, to avoid contention.
+   */
+  struct allocated_block_shard {
+    std::mutex mtx;
+    rmm::mr::detail::block_hash_set<block_type> blocks{
+      rmm::mr::detail::block_hash_set<block_type>::default_capacity / allocated_block_shards};
+  };
+
+  allocated_block_shard& get_allocated_block_shard(void const* p) noexcept
+  {
+    // Allocations are at least 256-byte aligned; fold in higher bits so that allocations of
+    // similar sizes spread evenly over the shards
+    auto const key = reinterpret_cast<std::uintptr_t>(p) >> 8;
+    return allocated_blocks_[(key ^ (key >> 5) ^ (key >> 12)) % allocated_block_shards];
+  }
+
+  // allocated blocks, looked up by pointer on deallocation
+  std::array<allocated_block_shard, allocated_block_shards> allocated_blocks_;
 
-  std::set<block_type, rmm::mr::detail::compare_blocks<block_type>> allocated_blocks_;
+  // sizes of the blocks allocated from upstream, by pointer: so they can be easily freed and found
+  std::unordered_map<char*, std::size_t> upstream_blocks_;
 
-  // blocks allocated from upstream: so they can be easily freed
-  std::vector<block_type> upstream_blocks_;
+  // Allocations larger than the threshold, made directly from upstream
+  std::atomic<std::size_t> large_allocation_threshold_{};  // 0 if no allocations bypass the pool
+  std::atomic<std::size_t> smallest_large_allocation_{std::numeric_limits<std::size_t>::max()};
+  std::atomic<std::size_t> large_allocated_bytes_{};
+  mutable std::mutex large_mtx_;
+  std::unordered_map<void*, std::size_t> large_allocations_;   // live. Guarded by large_mtx_
+  std::map<std::size_t, std::size_t> large_allocation_sizes_;  // live, count by size. Ditto
+  std::multimap<std::size_t, large_block> large_cache_;       // by size. Guarded by large_mtx_
+  std::size_t large_cache_size_{};                             // guarded by large_mtx_
+  std::size_t large_cached_bytes_{};                           // guarded by large_mtx_
 };  // namespace mr
 
 }  // namespace mr
@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <rmm/cuda_stream.hpp>
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/arena_memory_resource.hpp>
+#include <rmm/mr/device/cuda_memory_resource.hpp>
+#include <rmm/mr/device/detail/arena.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rmm {
+namespace test {
+namespace {
+
+using rmm::mr::detail::arena::best_fit;
+using rmm::mr::detail::arena::block;
+using rmm::mr::detail::arena::coalesce_block;
+using rmm::mr::detail::arena::free_block_set;
+using rmm::mr::detail::arena::global_arena;
+using rmm::mr::detail::arena::growth_policy;
+using rmm::mr::detail::arena::remote_free_queue;
+using rmm::mr::detail::arena::remote_free_queue_size;
+using rmm::mr::detail::arena::superblock_cache;
+using rmm::mr::detail::arena::superblock_cache_size;
+using rmm::mr::detail::arena::superblock_owners;
+
+// The free block set never dereferences block pointers, so tests can use fake addresses.
+char* const base = reinterpret_cast<char*>(0x10000);
+
+TEST(ArenaFreeBlockSetTest, BestFitLowestAddress)
+{
+  free_block_set blocks{};
+  blocks.insert(block{base, 1024});
+  blocks.insert(block{base + 2048, 512});
+  blocks.insert(block{base + 4096, 2048});
+  blocks.insert(block{base + 8192, 512});
+
+  auto b = best_fit(blocks, 300);
+  EXPECT_EQ(b.pointer(), base + 2048);  // smallest fit, lowest address
+  EXPECT_EQ(b.size(), 300);
+  EXPECT_EQ(blocks.size(), 4);  // the remainder is put back
+
+  b = best_fit(blocks, 1500);
+  EXPECT_EQ(b.pointer(), base + 4096);
+  EXPECT_EQ(b.size(), 1500);
+
+  b = best_fit(blocks, 512);
+  EXPECT_EQ(b.pointer(), base + 8192);
+  EXPECT_EQ(blocks.size(), 3);
+
+  EXPECT_FALSE(best_fit(blocks, 4096).is_valid());
+}
+
+TEST(ArenaFreeBlockSetTest, CoalesceUpdatesSizeIndex)
+{
+  free_block_set blocks{};
+  coalesce_block(blocks, block{base + 512, 256});
+  coalesce_block(blocks, block{base, 256});
+  EXPECT_EQ(blocks.size(), 2);
+  EXPECT_FALSE(best_fit(blocks, 512).is_valid());
+
+  auto const merged = coalesce_block(blocks, block{base + 256, 256});  // fills the gap
+  EXPECT_EQ(merged.pointer(), base);
+  EXPECT_EQ(merged.size(), 768);
+  EXPECT_EQ(blocks.size(), 1);
+
+  auto const b = best_fit(blocks, 768);
+  EXPECT_EQ(b.pointer(), base);
+  EXPECT_TRUE(blocks.empty());
+}
+
+TEST(ArenaFreeBlockSetTest, CoalesceStopsAtHead)
+{
+  free_block_set blocks{};
+  coalesce_block(blocks, block{base, 256, true});
+  coalesce_block(blocks, block{base + 512, 256, true});
+
+  // Merges with the head before it, but not into the head after it
+  auto const merged = coalesce_block(blocks, block{base + 256, 256});
+  EXPECT_EQ(merged.pointer(), base);
+  EXPECT_EQ(merged.size(), 512);
+  EXPECT_TRUE(merged.is_head());
+  EXPECT_EQ(blocks.size(), 2);
+  EXPECT_FALSE(best_fit(blocks, 768).is_valid());
+}
+
+TEST(ArenaFreeBlockSetTest, RandomChurn)
+{
+  constexpr std::size_t region_size{1 << 24};
+  free_block_set blocks{};
+  coalesce_block(blocks, block{base, region_size});
+
+  std::default_random_engine generator{42};
+  std::uniform_int_distribution<std::size_t> size_dist(1, 64);
+  std::vector<block> allocated;
+  for (int i = 0; i < 10000; ++i) {
+    if (allocated.empty() || generator() % 3 != 0) {
+      auto const b = best_fit(blocks, size_dist(generator) * 256);
+      if (b.is_valid()) { allocated.push_back(b); }
+    } else {
+      auto const victim = generator() % allocated.size();
+      coalesce_block(blocks, allocated[victim]);
+      allocated[victim] = allocated.back();
+      allocated.pop_back();
+    }
+  }
+
+  // Free blocks are disjoint, not contiguous, and all fit in the region with the allocated blocks
+  std::size_t free_bytes{};
+  for (auto iter = blocks.cbegin(); iter != blocks.cend(); ++iter) {
+    free_bytes += iter->size();
+    auto const next = std::next(iter);
+    if (next != blocks.cend()) {
+      EXPECT_LT(static_cast<char*>(iter->pointer()) + iter->size(), next->pointer());
+    }
+  }
+  std::size_t allocated_bytes{};
+  for (auto const& b : allocated) {
+    allocated_bytes += b.size();
+  }
+  EXPECT_EQ(free_bytes + allocated_bytes, region_size);
+
+  for (auto const& b : allocated) {
+    coalesce_block(blocks, b);
+  }
+  EXPECT_EQ(blocks.size(), 1);
+  EXPECT_EQ(best_fit(blocks, region_size).size(), region_size);
+}
+
+TEST(ArenaSuperblockOwnersTest, FindAndErase)
+{
+  int first{};
+  int second{};
+  superblock_owners<int> owners{};
+  owners.insert(block{base, 4096}, &first);
+  owners.insert(block{base + 4096, 4096}, &second);
+
+  EXPECT_EQ(owners.find(base), &first);
+  EXPECT_EQ(owners.find(base + 4095), &first);
+  EXPECT_EQ(owners.find(base + 4096), &second);
+  EXPECT_EQ(owners.find(base + 8192), nullptr);
+  EXPECT_EQ(owners.find(base - 1), nullptr);
+
+  // Erasing across both superblocks keeps the parts outside the erased range
+  owners.erase(block{base + 1024, 4096});
+  EXPECT_EQ(owners.find(base + 1023), &first);
+  EXPECT_EQ(owners.find(base + 1024), nullptr);
+  EXPECT_EQ(owners.find(base + 5119), nullptr);
+  EXPECT_EQ(owners.find(base + 5120), &second);
+
+  // Erasing from the middle of a superblock splits it
+  owners.erase(block{base + 6144, 256});
+  EXPECT_EQ(owners.find(base + 6143), &second);
+  EXPECT_EQ(owners.find(base + 6144), nullptr);
+  EXPECT_EQ(owners.find(base + 6400), &second);
+
+  // Registering memory again replaces any stale owner
+  owners.insert(block{base, 8192}, &first);
+  EXPECT_EQ(owners.find(base + 6144), &first);
+  EXPECT_EQ(owners.find(base + 8191), &first);
+}
+
+TEST(ArenaSuperblockCacheTest, InsertTakeDrain)
+{
+  superblock_cache cache{};
+  EXPECT_EQ(cache.take(), nullptr);
+  EXPECT_EQ(cache.misses(), 1);
+
+  for (std::size_t i = 0; i < superblock_cache_size; ++i) {
+    EXPECT_TRUE(cache.insert(base + i * 4096));
+  }
+  EXPECT_FALSE(cache.insert(base + superblock_cache_size * 4096));  // full
+
+  auto* const p = static_cast<char*>(cache.take());
+  EXPECT_NE(p, nullptr);
+  EXPECT_EQ((p - base) % 4096, 0);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_TRUE(cache.insert(p));
+
+  std::size_t drained{0};
+  cache.drain([&drained](void*) { ++drained; });
+  EXPECT_EQ(drained, superblock_cache_size);
+  EXPECT_EQ(cache.take(), nullptr);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 2);
+}
+
+TEST(ArenaRemoteFreeQueueTest, PushPopInOrderUntilFull)
+{
+  auto const b = [](std::size_t i) { return block{reinterpret_cast<void*>((i + 1) << 8), 256}; };
+  remote_free_queue queue;
+  EXPECT_FALSE(queue.pop().is_valid());
+
+  // Twice round the slots, filling the queue each time
+  for (int lap = 0; lap < 2; ++lap) {
+    for (std::size_t i = 0; i < remote_free_queue_size; ++i) {
+      EXPECT_TRUE(queue.push(b(i)));
+    }
+    EXPECT_FALSE(queue.push(b(remote_free_queue_size)));
+    for (std::size_t i = 0; i < remote_free_queue_size; ++i) {
+      EXPECT_EQ(queue.pop().pointer(), b(i).pointer());
+    }
+    EXPECT_FALSE(queue.pop().is_valid());
+  }
+}
+
+TEST(ArenaGrowthPolicyTest, SizeToGrow)
+{
+  constexpr std::size_t maximum_size{1 << 20};
+
+  auto const all_at_once = growth_policy::all_at_once();
+  EXPECT_EQ(all_at_once.size_to_grow(256, 0, maximum_size), maximum_size);
+  EXPECT_EQ(all_at_once.size_to_grow(256, 4096, maximum_size), maximum_size - 4096);
+
+  auto const fixed_chunk = growth_policy::fixed_chunk(4096);
+  EXPECT_EQ(fixed_chunk.size_to_grow(256, 0, maximum_size), 4096);
+  EXPECT_EQ(fixed_chunk.size_to_grow(4352, 0, maximum_size), 8192);
+  EXPECT_EQ(fixed_chunk.size_to_grow(256, maximum_size - 1024, maximum_size), 1024);
+
+  auto const geometric = growth_policy::geometric();
+  EXPECT_EQ(geometric.size_to_grow(256, 0, maximum_size), 256);
+  EXPECT_EQ(geometric.size_to_grow(256, 8192, maximum_size), 8192);
+  EXPECT_EQ(geometric.size_to_grow(16384, 8192, maximum_size), 16384);
+  EXPECT_EQ(geometric.size_to_grow(256, 3 * maximum_size / 4, maximum_size), maximum_size / 4);
+
+  // Requests that do not fit in the remaining size cannot grow the arena
+  EXPECT_EQ(all_at_once.size_to_grow(maximum_size + 256, 0, maximum_size), 0);
+  EXPECT_EQ(geometric.size_to_grow(4096, maximum_size - 1024, maximum_size), 0);
+}
+
+TEST(ArenaGrowthPolicyTest, FixedChunkRequiresAlignment)
+{
+  EXPECT_THROW(growth_policy::fixed_chunk(0), rmm::logic_error);
+  EXPECT_THROW(growth_policy::fixed_chunk(1000), rmm::logic_error);
+  EXPECT_NO_THROW(growth_policy::fixed_chunk(1024));
+}
+
+/// Hands out consecutive chunks of one buffer, so that separate allocations are contiguous.
+class contiguous_resource {
+ public:
+  void* allocate(std::size_t bytes)
+  {
+    if (used_ + bytes > buffer_.size()) { throw std::bad_alloc{}; }
+    auto* const p = buffer_.data() + used_;
+    used_ += bytes;
+    return p;
+  }
+  void deallocate(void*, std::size_t) {}
+  char* base() { return buffer_.data(); }
+
+ private:
+  alignas(256) std::array<char, 1 << 20> buffer_{};
+  std::size_t used_{};
+};
+
+TEST(ArenaGlobalTest, NeverMergesUpstreamAllocations)
+{
+  constexpr std::size_t superblock_size{1 << 16};
+  contiguous_resource upstream;
+  auto const policy = growth_policy::fixed_chunk(superblock_size);
+  global_arena<contiguous_resource> arena{
+    &upstream, 0, 4 * superblock_size, superblock_size, policy};
+
+  // Two upstream allocations that happen to be contiguous, freed through the superblock cache
+  auto const first  = arena.allocate(superblock_size);
+  auto const second = arena.allocate(superblock_size);
+  EXPECT_EQ(first.pointer(), upstream.base());
+  EXPECT_EQ(second.pointer(), upstream.base() + superblock_size);
+  EXPECT_TRUE(first.is_head());
+  EXPECT_TRUE(second.is_head());
+  arena.deallocate(first);
+  arena.deallocate(second);
+
+  // Spanning both is not possible, so the arena grows
+  auto const both = arena.allocate(2 * superblock_size);
+  EXPECT_EQ(both.pointer(), upstream.base() + 2 * superblock_size);
+  EXPECT_EQ(arena.size(), 4 * superblock_size);
+
+  // Taken from the cache, each keeps its head
+  auto const again = arena.allocate(superblock_size);
+  EXPECT_TRUE(again.is_head());
+  arena.deallocate(again);
+  arena.deallocate(both);
+}
+
+TEST(ArenaTest, SuperblockSizeAndGrowth)
+{
+  using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t maximum_size{1 << 24};
+  constexpr std::size_t superblock_size{1 << 16};
+  rmm::mr::cuda_memory_resource cuda;
+
+  EXPECT_THROW(arena_mr(&cuda, 0, maximum_size, 0), rmm::logic_error);
+  EXPECT_THROW(arena_mr(&cuda, 0, maximum_size, superblock_size + 1), rmm::logic_error);
+
+  arena_mr mr{&cuda, 0, maximum_size, superblock_size, rmm::mr::arena_growth_policy::geometric()};
+  EXPECT_EQ(mr.get_superblock_size(), superblock_size);
+  EXPECT_EQ(mr.get_arena_size(), 0);
+
+  // A small allocation grows the global arena by one superblock
+  void* p = mr.allocate(1024);
+  EXPECT_EQ(mr.get_arena_size(), superblock_size);
+
+  // A second superblock doubles it
+  void* q = mr.allocate(superblock_size);
+  EXPECT_EQ(mr.get_arena_size(), 2 * superblock_size);
+
+  mr.deallocate(q, superblock_size);
+  mr.deallocate(p, 1024);
+}
+
+TEST(ArenaTest, SuperblockCacheAbsorbsThreadChurn)
+{
+  using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t arena_size{1 << 22};
+  rmm::mr::cuda_memory_resource cuda;
+  arena_mr mr{&cuda, arena_size, arena_size};
+
+  // Each short-lived thread returns its superblock when it frees its allocation, and the next
+  // thread takes it from the cache
+  constexpr int num_threads{4};
+  for (int i = 0; i < num_threads; ++i) {
+    std::thread{[&mr]() {
+      void* p = mr.allocate(1024, rmm::cuda_stream_per_thread);
+      mr.deallocate(p, 1024, rmm::cuda_stream_per_thread);
+    }}.join();
+  }
+  EXPECT_EQ(mr.get_superblock_cache_misses(), 1);
+  EXPECT_EQ(mr.get_superblock_cache_hits(), num_threads - 1);
+}
+
+TEST(ArenaTest, CrossStreamDeallocation)
+{
+  using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t arena_size{1 << 22};
+  rmm::mr::cuda_memory_resource cuda;
+  arena_mr mr{&cuda, arena_size, arena_size};
+  rmm::cuda_stream producer;
+  rmm::cuda_stream consumer;
+
+  void* p = mr.allocate(1024, producer);
+  mr.deallocate(p, 1024, consumer);
+  // Returned to the producer's arena, which reuses it
+  EXPECT_EQ(mr.allocate(1024, producer), p);
+  mr.deallocate(p, 1024, producer);
+}
+
+TEST(ArenaTest, RemoteFreeToIdleThreadIsReusable)
+{
+  using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t arena_size{1 << 22};
+  constexpr std::size_t size{3 << 20};
+  rmm::mr::cuda_memory_resource cuda;
+  arena_mr mr{&cuda, arena_size, arena_size};
+
+  // The producer allocates most of the arena, then idles while this thread frees and reallocates
+  std::promise<void*> allocated;
+  std::promise<void> done;
+  std::thread producer{[&]() {
+    allocated.set_value(mr.allocate(size, rmm::cuda_stream_per_thread));
+    done.get_future().wait();
+  }};
+  void* p = allocated.get_future().get();
+  mr.deallocate(p, size, rmm::cuda_stream_per_thread);
+
+  void* q{};
+  EXPECT_NO_THROW(q = mr.allocate(size, rmm::cuda_stream_per_thread));
+  done.set_value();
+  producer.join();
+  if (q != nullptr) { mr.deallocate(q, size, rmm::cuda_stream_per_thread); }
+}
+
+TEST(ArenaTest, RemoteFreesRacingCleanReturnEverySuperblock)
+{
+  using arena_type = rmm::mr::detail::arena::arena<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t arena_size{1 << 22};
+  constexpr std::size_t size{1 << 16};
+  constexpr int num_arenas{8};
+  constexpr int blocks_per_arena{4};
+  rmm::mr::cuda_memory_resource cuda;
+  global_arena<rmm::mr::cuda_memory_resource> global{&cuda, arena_size, arena_size};
+  superblock_owners<arena_type> owners;
+
+  // Each arena's thread exits while other threads free the blocks it allocated
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    std::vector<std::shared_ptr<arena_type>> arenas;
+    std::vector<std::vector<void*>> allocated(num_arenas);
+    for (int i = 0; i < num_arenas; ++i) {
+      arenas.push_back(std::make_shared<arena_type>(global, owners));
+      for (int j = 0; j < blocks_per_arena; ++j) {
+        allocated[i].push_back(arenas[i]->allocate(size));
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_arenas; ++i) {
+      threads.emplace_back([&arenas, i]() { arenas[i]->clean(); });
+      threads.emplace_back([&arenas, &allocated, i]() {
+        for (auto* p : allocated[i]) {
+          arenas[i]->deallocate_remote(p, size);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    arenas.clear();
+
+    // No block is left in the queue of a cleaned arena
+    block all;
+    ASSERT_NO_THROW(all = global.allocate(arena_size));
+    global.deallocate(all);
+  }
+}
+
+TEST(ArenaTest, ThreadArenaOfRecreatedResource)
+{
+  using arena_mr = rmm::mr::arena_memory_resource<rmm::mr::cuda_memory_resource>;
+  constexpr std::size_t arena_size{1 << 22};
+  rmm::mr::cuda_memory_resource cuda;
+
+  // A resource constructed where a destroyed one was must not use the destroyed one's arena,
+  // which this thread has cached
+  std::aligned_storage<sizeof(arena_mr), alignof(arena_mr)>::type storage;
+  for (int i = 0; i < 2; ++i) {
+    auto* mr = new (&storage) arena_mr{&cuda, arena_size, arena_size};
+    void* p  = mr->allocate(1024, rmm::cuda_stream_per_thread);
+    EXPECT_NE(p, nullptr);
+    mr->deallocate(p, 1024, rmm::cuda_stream_per_thread);
+    mr->~arena_mr();
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace rmm
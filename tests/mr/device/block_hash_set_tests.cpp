@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <rmm/mr/device/detail/block_hash_set.hpp>
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace rmm {
+namespace test {
+namespace {
+
+using rmm::mr::detail::block;
+using block_set = rmm::mr::detail::block_hash_set<block>;
+
+// The set never dereferences block pointers, so tests can use fake addresses.
+char* const base = reinterpret_cast<char*>(0x10000);
+
+TEST(BlockHashSetTest, Empty)
+{
+  block_set set{};
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+  EXPECT_EQ(set.find(base), set.end());
+}
+
+TEST(BlockHashSetTest, InsertFindErase)
+{
+  block_set set{};
+  set.insert(block{base, 256, true});
+  set.insert(block{base + 256, 512, false});
+  EXPECT_EQ(set.size(), 2);
+
+  auto iter = set.find(base + 256);
+  ASSERT_NE(iter, set.end());
+  EXPECT_EQ(iter->size(), 512);
+  EXPECT_EQ(set.find(base + 128), set.end());
+
+  set.erase(iter);
+  EXPECT_EQ(set.size(), 1);
+  EXPECT_EQ(set.find(base + 256), set.end());
+  EXPECT_NE(set.find(base), set.end());
+}
+
+TEST(BlockHashSetTest, ReserveAvoidsRehash)
+{
+  block_set set{};
+  set.reserve(10000);
+  auto const capacity = set.capacity();
+  for (std::size_t i = 0; i < 10000; ++i) {
+    set.insert(block{base + i * 256, 256, false});
+  }
+  EXPECT_EQ(set.capacity(), capacity);
+  EXPECT_EQ(std::distance(set.begin(), set.end()), 10000);
+}
+
+// Random churn with a small initial capacity exercises growth and backward-shift deletion
+TEST(BlockHashSetTest, RandomChurn)
+{
+  block_set set{16};
+  std::default_random_engine generator{42};
+  std::vector<block> present;
+  std::size_t next{0};
+
+  for (int i = 0; i < 100000; ++i) {
+    if (present.empty() || generator() % 100 < 55) {
+      block const b{base + (next++) * 256, 256, false};
+      set.insert(b);
+      present.push_back(b);
+    } else {
+      auto const index = generator() % present.size();
+      auto const iter  = set.find(present[index].pointer());
+      ASSERT_NE(iter, set.end());
+      set.erase(iter);
+      EXPECT_EQ(set.find(present[index].pointer()), set.end());
+      present[index] = present.back();
+      present.pop_back();
+    }
+    ASSERT_EQ(set.size(), present.size());
+  }
+
+  for (auto const& b : present) {
+    EXPECT_NE(set.find(b.pointer()), set.end());
+  }
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace rmm
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/deferred_coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
+#include <rmm/mr/device/detail/tlsf_free_list.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace rmm {
+namespace test {
+namespace {
+
+using rmm::mr::detail::block;
+
+// Free lists never dereference block pointers, so tests can use fake addresses.
+char* const base = reinterpret_cast<char*>(0x10000);
+
+template <typename FreeList>
+struct FreeListTest : public ::testing::Test {
+  FreeList list{};
+};
+
+using free_list_types = ::testing::Types<rmm::mr::detail::coalescing_free_list,
+                                         rmm::mr::detail::indexed_free_list,
+                                         rmm::mr::detail::tlsf_free_list>;
+
+TYPED_TEST_CASE(FreeListTest, free_list_types);
+
+template <typename FreeList>
+struct BestFitFreeListTest : public FreeListTest<FreeList> {
+};
+
+using best_fit_free_list_types =
+  ::testing::Types<rmm::mr::detail::coalescing_free_list, rmm::mr::detail::indexed_free_list>;
+
+TYPED_TEST_CASE(BestFitFreeListTest, best_fit_free_list_types);
+
+TYPED_TEST(FreeListTest, EmptyList)
+{
+  EXPECT_TRUE(this->list.is_empty());
+  EXPECT_FALSE(this->list.get_block(256).is_valid());
+}
+
+TYPED_TEST(FreeListTest, CoalesceOnInsert)
+{
+  this->list.insert(block{base + 512, 256, false});
+  this->list.insert(block{base, 256, true});
+  EXPECT_EQ(this->list.size(), 2);
+  this->list.insert(block{base + 256, 256, false});  // fills the gap
+  EXPECT_EQ(this->list.size(), 1);
+
+  auto b = this->list.get_block(768);
+  EXPECT_EQ(b.pointer(), base);
+  EXPECT_EQ(b.size(), 768);
+  EXPECT_TRUE(b.is_head());
+  EXPECT_TRUE(this->list.is_empty());
+}
+
+TYPED_TEST(FreeListTest, NoCoalesceAcrossHead)
+{
+  this->list.insert(block{base, 256, true});
+  this->list.insert(block{base + 256, 256, true});
+  EXPECT_EQ(this->list.size(), 2);
+  EXPECT_FALSE(this->list.get_block(512).is_valid());
+}
+
+TYPED_TEST(BestFitFreeListTest, BestFit)
+{
+  this->list.insert(block{base, 1024, true});
+  this->list.insert(block{base + 2048, 512, true});
+  this->list.insert(block{base + 4096, 2048, true});
+  this->list.insert(block{base + 8192, 512, true});
+
+  auto b = this->list.get_block(300);
+  EXPECT_EQ(b.pointer(), base + 2048);  // smallest fit, lowest address
+  EXPECT_EQ(b.size(), 512);
+
+  b = this->list.get_block(1500);
+  EXPECT_EQ(b.pointer(), base + 4096);
+  EXPECT_EQ(this->list.size(), 2);
+
+  EXPECT_FALSE(this->list.get_block(4096).is_valid());
+}
+
+TYPED_TEST(BestFitFreeListTest, LowestAndHighestFit)
+{
+  this->list.insert(block{base, 512, true});
+  this->list.insert(block{base + 2048, 1024, true});
+  this->list.insert(block{base + 4096, 2048, true});
+  this->list.insert(block{base + 8192, 1024, true});
+
+  auto b = this->list.get_lowest_block(600);
+  EXPECT_EQ(b.pointer(), base + 2048);
+  b = this->list.get_highest_block(600);
+  EXPECT_EQ(b.pointer(), base + 8192);
+  b = this->list.get_highest_block(1500);
+  EXPECT_EQ(b.pointer(), base + 4096);
+  EXPECT_EQ(this->list.size(), 1);
+
+  EXPECT_FALSE(this->list.get_lowest_block(1024).is_valid());
+  EXPECT_FALSE(this->list.get_highest_block(1024).is_valid());
+}
+
+TYPED_TEST(FreeListTest, MergeLists)
+{
+  TypeParam other{};
+  this->list.insert(block{base, 256, true});
+  this->list.insert(block{base + 512, 256, false});
+  other.insert(block{base + 256, 256, false});
+  other.insert(block{base + 4096, 256, true});
+
+  this->list.insert(std::move(other));
+  EXPECT_EQ(this->list.size(), 2);
+  EXPECT_EQ(this->list.get_block(768).pointer(), base);
+}
+
+// Merging fragmented, interleaved lists must coalesce exactly as inserting one block at a time
+TYPED_TEST(FreeListTest, MergeInterleavedLists)
+{
+  TypeParam other{};
+  TypeParam reference{};
+  constexpr std::size_t num_blocks{1000};
+  for (std::size_t i = 0; i < num_blocks; ++i) {
+    block const b{base + i * 256, 256, i % 7 == 0};
+    // every third block is in neither list, so merging leaves gaps
+    if (i % 3 == 1) { continue; }
+    if (i % 3 == 0) {
+      this->list.insert(b);
+    } else {
+      other.insert(b);
+    }
+    reference.insert(b);
+  }
+
+  this->list.insert(std::move(other));
+  EXPECT_TRUE(other.is_empty());
+  auto const sorted_blocks = [](TypeParam const& list) {
+    std::vector<block> blocks(list.cbegin(), list.cend());
+    std::sort(blocks.begin(), blocks.end());
+    return blocks;
+  };
+  auto const merged   = sorted_blocks(this->list);
+  auto const expected = sorted_blocks(reference);
+  EXPECT_TRUE(std::equal(merged.cbegin(),
+                         merged.cend(),
+                         expected.cbegin(),
+                         expected.cend(),
+                         [](block const& lhs, block const& rhs) {
+                           return lhs.pointer() == rhs.pointer() && lhs.size() == rhs.size() &&
+                                  lhs.is_head() == rhs.is_head();
+                         }));
+}
+
+// The indexed list must make exactly the same choices as the reference (linear) implementation
+TYPED_TEST(FreeListTest, LargestBlockSizeTracksChurn)
+{
+  auto& list = this->list;
+  std::default_random_engine generator{7};
+  std::uniform_int_distribution<std::size_t> size_distribution(1, 64);
+
+  auto const expected_largest = [&list]() {
+    std::size_t largest{0};
+    std::for_each(list.cbegin(), list.cend(), [&largest](block const& b) {
+      largest = std::max(largest, b.size());
+    });
+    return largest;
+  };
+
+  constexpr std::size_t region_size{std::size_t{1} << 24};
+  list.insert(block{base, region_size, true});
+  EXPECT_EQ(list.largest_block_size(), region_size);
+
+  std::vector<block> allocated;
+  for (int i = 0; i < 5000; ++i) {
+    if (allocated.empty() || generator() % 100 < 55) {
+      auto const size = size_distribution(generator) * 256;
+      auto const b    = list.get_block(size);
+      ASSERT_TRUE(b.is_valid());
+      if (b.size() > size) { list.insert(block{b.pointer() + size, b.size() - size, false}); }
+      allocated.emplace_back(b.pointer(), size, b.is_head());
+    } else {
+      auto const index = generator() % allocated.size();
+      list.insert(allocated[index]);
+      allocated[index] = allocated.back();
+      allocated.pop_back();
+    }
+    ASSERT_EQ(list.largest_block_size(), expected_largest());
+  }
+
+  list.clear();
+  EXPECT_EQ(list.largest_block_size(), 0);
+}
+
+TEST(IndexedFreeListTest, MatchesCoalescingFreeList)
+{
+  rmm::mr::detail::coalescing_free_list reference{};
+  rmm::mr::detail::indexed_free_list indexed{};
+
+  // carve a region into blocks, some of which start new "upstream" allocations
+  constexpr std::size_t num_blocks{2000};
+  std::default_random_engine generator{42};
+  std::uniform_int_distribution<std::size_t> size_distribution(1, 64);
+  std::vector<block> allocated;
+  char* ptr = base;
+  for (std::size_t i = 0; i < num_blocks; ++i) {
+    auto const size = size_distribution(generator) * 256;
+    allocated.emplace_back(ptr, size, i % 100 == 0);
+    ptr += size;
+  }
+  std::shuffle(allocated.begin(), allocated.end(), generator);
+
+  for (std::size_t i = 0; i < allocated.size(); ++i) {
+    reference.insert(allocated[i]);
+    indexed.insert(allocated[i]);
+    if (i % 3 == 0) {
+      auto const size = size_distribution(generator) * 256;
+      auto const r    = reference.get_block(size);
+      auto const b    = indexed.get_block(size);
+      EXPECT_EQ(r.pointer(), b.pointer());
+      EXPECT_EQ(r.size(), b.size());
+    }
+    ASSERT_EQ(reference.size(), indexed.size());
+  }
+  EXPECT_TRUE(std::equal(reference.cbegin(),
+                         reference.cend(),
+                         indexed.cbegin(),
+                         [](block const& lhs, block const& rhs) {
+                           return lhs.pointer() == rhs.pointer() && lhs.size() == rhs.size();
+                         }));
+}
+
+TEST(TLSFFreeListTest, ExactSizeInSameClass)
+{
+  rmm::mr::detail::tlsf_free_list list{};
+  // 1000 * 256 bytes is not a class boundary, so the rounded-up search alone would miss it
+  list.insert(block{base, 1000 * 256, true});
+  auto const b = list.get_block(1000 * 256);
+  EXPECT_EQ(b.pointer(), base);
+  EXPECT_TRUE(list.is_empty());
+}
+
+TEST(TLSFFreeListTest, RandomChurn)
+{
+  rmm::mr::detail::tlsf_free_list list{};
+  std::default_random_engine generator{42};
+  std::uniform_int_distribution<std::size_t> size_distribution(1, 1024);
+
+  constexpr std::size_t region_size{std::size_t{1} << 30};
+  list.insert(block{base, region_size, true});
+
+  std::vector<block> allocated;
+  for (int i = 0; i < 20000; ++i) {
+    if (allocated.empty() || generator() % 100 < 60) {
+      auto const size = size_distribution(generator) * 256;
+      auto const b    = list.get_block(size);
+      ASSERT_TRUE(b.is_valid());
+      ASSERT_GE(b.size(), size);
+      if (b.size() > size) { list.insert(block{b.pointer() + size, b.size() - size, false}); }
+      allocated.emplace_back(b.pointer(), size, b.is_head());
+    } else {
+      auto const index = generator() % allocated.size();
+      list.insert(allocated[index]);
+      allocated[index] = allocated.back();
+      allocated.pop_back();
+    }
+  }
+  for (auto const& b : allocated) {
+    list.insert(b);
+  }
+
+  // Everything coalesced back into the original region, and copies rebuild the indices
+  rmm::mr::detail::tlsf_free_list copy{list};
+  EXPECT_EQ(list.size(), 1);
+  auto const b = copy.get_block(region_size);
+  EXPECT_EQ(b.pointer(), base);
+  EXPECT_EQ(b.size(), region_size);
+  EXPECT_TRUE(copy.is_empty());
+}
+
+TEST(DeferredCoalescingFreeListTest, ReusesRecentBlock)
+{
+  rmm::mr::detail::deferred_coalescing_free_list<> list{};
+  list.insert(block{base, 4096, true});
+  auto const b = list.get_block(256);  // not a near fit, so the whole block is returned
+  EXPECT_EQ(b.size(), 4096);
+  list.insert(block{base + 256, 3840, false});
+  list.insert(block{base, 256, true});
+  EXPECT_EQ(list.size(), 2);  // not coalesced yet
+
+  auto const again = list.get_block(256);
+  EXPECT_EQ(again.pointer(), base);
+  EXPECT_EQ(again.size(), 256);
+  list.insert(again);
+
+  // A miss in the unsorted bin coalesces it
+  auto const whole = list.get_block(4096);
+  EXPECT_EQ(whole.pointer(), base);
+  EXPECT_EQ(whole.size(), 4096);
+  EXPECT_TRUE(list.is_empty());
+}
+
+TEST(DeferredCoalescingFreeListTest, CoalescesFullBinAndOnIteration)
+{
+  rmm::mr::detail::deferred_coalescing_free_list<rmm::mr::detail::coalescing_free_list, 4> list{};
+  for (std::size_t i = 0; i < 5; ++i) {
+    list.insert(block{base + i * 256, 256, i == 0});
+  }
+  EXPECT_EQ(list.size(), 2);  // the first four were coalesced when the fifth was inserted
+  EXPECT_EQ(list.largest_block_size(), 1024);
+
+  EXPECT_EQ(std::distance(list.begin(), list.end()), 1);
+  EXPECT_EQ(list.size(), 1);
+  EXPECT_EQ(list.largest_block_size(), 1280);
+}
+
+TEST(DeferredCoalescingFreeListTest, RandomChurn)
+{
+  rmm::mr::detail::deferred_coalescing_free_list<rmm::mr::detail::indexed_free_list> list{};
+  std::default_random_engine generator{42};
+  std::uniform_int_distribution<std::size_t> size_distribution(1, 64);
+
+  constexpr std::size_t region_size{std::size_t{1} << 30};
+  list.insert(block{base, region_size, true});
+
+  std::vector<block> allocated;
+  for (int i = 0; i < 20000; ++i) {
+    if (allocated.empty() || generator() % 100 < 60) {
+      auto const size = size_distribution(generator) * 256;
+      auto const b    = list.get_block(size);
+      ASSERT_TRUE(b.is_valid());
+      ASSERT_GE(b.size(), size);
+      if (b.size() > size) { list.insert(block{b.pointer() + size, b.size() - size, false}); }
+      allocated.emplace_back(b.pointer(), size, b.is_head());
+    } else {
+      auto const index = generator() % allocated.size();
+      list.insert(allocated[index]);
+      allocated[index] = allocated.back();
+      allocated.pop_back();
+    }
+  }
+  for (auto const& b : allocated) {
+    list.insert(b);
+  }
+
+  // Everything coalesces back into the original region
+  list.coalesce();
+  EXPECT_EQ(list.size(), 1);
+  auto const b = list.get_block(region_size);
+  EXPECT_EQ(b.pointer(), base);
+  EXPECT_EQ(b.size(), region_size);
+  EXPECT_TRUE(list.is_empty());
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace rmm
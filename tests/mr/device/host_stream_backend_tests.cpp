@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmarks/utilities/simulated_memory_resource.hpp>
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/arena_memory_resource.hpp>
+#include <rmm/mr/device/detail/host_stream_backend.hpp>
+#include <rmm/mr/device/detail/indexed_free_list.hpp>
+#include <rmm/mr/device/pool_memory_resource.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace rmm {
+namespace test {
+namespace {
+
+using backend = rmm::mr::detail::host_stream_backend;
+using host_pool_mr =
+  rmm::mr::pool_memory_resource<rmm::mr::simulated_memory_resource,
+                                rmm::mr::detail::indexed_free_list,
+                                backend>;
+using host_arena_mr =
+  rmm::mr::arena_memory_resource<rmm::mr::simulated_memory_resource, backend>;
+
+// Fake stream handles, distinct from the special handles cudaStreamLegacy and cudaStreamPerThread
+cudaStream_t const s1{reinterpret_cast<cudaStream_t>(0x100)};
+cudaStream_t const s2{reinterpret_cast<cudaStream_t>(0x200)};
+
+constexpr std::size_t one_mib{std::size_t{1} << 20};
+
+void sleep_briefly() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+TEST(HostStreamBackendTest, WorkRunsInOrder)
+{
+  std::vector<int> order;
+  for (int i = 0; i < 100; ++i) {
+    backend::enqueue(s1, [&order, i]() { order.push_back(i); });
+  }
+  EXPECT_EQ(backend::synchronize_stream(s1), cudaSuccess);
+  ASSERT_EQ(order.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST(HostStreamBackendTest, WaitEventOrdersStreams)
+{
+  cudaEvent_t event{};
+  EXPECT_EQ(backend::create_event(&event), cudaSuccess);
+
+  std::atomic<bool> done{false};
+  bool done_before_wait{false};
+  backend::enqueue(s1, [&done]() {
+    sleep_briefly();
+    done = true;
+  });
+  EXPECT_EQ(backend::record_event(event, s1), cudaSuccess);
+  EXPECT_EQ(backend::stream_wait_event(s2, event), cudaSuccess);
+  backend::enqueue(s2, [&]() { done_before_wait = done; });
+
+  EXPECT_EQ(backend::synchronize_stream(s2), cudaSuccess);
+  EXPECT_TRUE(done_before_wait);
+  EXPECT_EQ(backend::destroy_event(event), cudaSuccess);
+}
+
+TEST(HostStreamBackendTest, SynchronizeEvent)
+{
+  cudaEvent_t event{};
+  EXPECT_EQ(backend::create_event(&event), cudaSuccess);
+  EXPECT_EQ(backend::synchronize_event(event), cudaSuccess);  // never recorded, so complete
+
+  std::atomic<bool> done{false};
+  backend::enqueue(s1, [&done]() {
+    sleep_briefly();
+    done = true;
+  });
+  EXPECT_EQ(backend::record_event(event, s1), cudaSuccess);
+  EXPECT_EQ(backend::synchronize_event(event), cudaSuccess);
+  EXPECT_TRUE(done);
+  EXPECT_EQ(backend::destroy_event(event), cudaSuccess);
+}
+
+// A block freed on one stream while work using it is pending must not be used by another stream's
+// work until that work completes.
+TEST(HostStreamBackendTest, PoolOrdersStolenBlocks)
+{
+  rmm::mr::simulated_memory_resource upstream{one_mib};
+  host_pool_mr mr{&upstream, one_mib, one_mib};
+
+  auto const p1 = mr.allocate(one_mib, cuda_stream_view{s1});
+  std::atomic<bool> done{false};
+  backend::enqueue(s1, [&done]() {
+    sleep_briefly();
+    done = true;
+  });
+  mr.deallocate(p1, one_mib, cuda_stream_view{s1});
+
+  auto const p2 = mr.allocate(one_mib, cuda_stream_view{s2});
+  EXPECT_EQ(p2, p1);
+  EXPECT_EQ(mr.get_steal_count(), 2);  // the first allocation stole from the default stream
+  bool done_before_use{false};
+  backend::enqueue(s2, [&]() { done_before_use = done; });
+  EXPECT_EQ(backend::synchronize_stream(s2), cudaSuccess);
+  EXPECT_TRUE(done_before_use);
+
+  mr.deallocate(p2, one_mib, cuda_stream_view{s2});
+}
+
+// A stream should take blocks freed on a stream whose work has completed without waiting, in
+// preference to blocks that are still in use by work in flight on another stream.
+TEST(HostStreamBackendTest, PoolPrefersCompletedStreams)
+{
+  cudaStream_t const s3{reinterpret_cast<cudaStream_t>(0x300)};
+  rmm::mr::simulated_memory_resource upstream{2 * one_mib};
+  host_pool_mr mr{&upstream, 2 * one_mib, 2 * one_mib};
+
+  auto const p1 = mr.allocate(one_mib, cuda_stream_view{s1});
+  auto const p3 = mr.allocate(one_mib, cuda_stream_view{s3});
+  EXPECT_EQ(mr.get_free_steal_count(), 2);  // nothing was in flight
+
+  // Work on s1 using p1 stays in flight until released
+  std::atomic<bool> release{false};
+  std::atomic<bool> done{false};
+  backend::enqueue(s1, [&]() {
+    while (not release) {
+      std::this_thread::yield();
+    }
+    done = true;
+  });
+  mr.deallocate(p1, one_mib, cuda_stream_view{s1});
+  mr.deallocate(p3, one_mib, cuda_stream_view{s3});
+  EXPECT_EQ(backend::synchronize_stream(s3), cudaSuccess);
+
+  // Taken from s3 without a wait, so work on s2 can complete while s1's work is in flight
+  auto const p2 = mr.allocate(one_mib, cuda_stream_view{s2});
+  EXPECT_EQ(p2, p3);
+  EXPECT_EQ(mr.get_free_steal_count(), 3);
+  EXPECT_EQ(mr.get_ordered_steal_count(), 0);
+  EXPECT_EQ(backend::synchronize_stream(s2), cudaSuccess);
+  EXPECT_FALSE(done);
+
+  // Only s1's block is left, so s2 must wait on s1 to use it
+  auto const p4 = mr.allocate(one_mib, cuda_stream_view{s2});
+  EXPECT_EQ(p4, p1);
+  EXPECT_EQ(mr.get_ordered_steal_count(), 1);
+  bool done_before_use{false};
+  backend::enqueue(s2, [&]() { done_before_use = done; });
+  release = true;
+  EXPECT_EQ(backend::synchronize_stream(s2), cudaSuccess);
+  EXPECT_TRUE(done_before_use);
+
+  mr.deallocate(p2, one_mib, cuda_stream_view{s2});
+  mr.deallocate(p4, one_mib, cuda_stream_view{s2});
+}
+
+TEST(HostStreamBackendTest, PoolOrdersBlocksWithinGroup)
+{
+  cudaStream_t const g1{reinterpret_cast<cudaStream_t>(0x1100)};
+  cudaStream_t const g2{reinterpret_cast<cudaStream_t>(0x1200)};
+  rmm::mr::simulated_memory_resource upstream{one_mib};
+  host_pool_mr mr{&upstream, one_mib, one_mib};
+  mr.add_stream_group({cuda_stream_view{g1}, cuda_stream_view{g2}});
+
+  auto const p1 = mr.allocate(one_mib, cuda_stream_view{g1});
+  std::atomic<bool> done{false};
+  backend::enqueue(g1, [&done]() {
+    sleep_briefly();
+    done = true;
+  });
+  mr.deallocate(p1, one_mib, cuda_stream_view{g1});
+
+  auto const steals = mr.get_steal_count();
+  auto const p2     = mr.allocate(one_mib, cuda_stream_view{g2});
+  EXPECT_EQ(p2, p1);
+  EXPECT_EQ(mr.get_steal_count(), steals);  // reused from the group's free list
+  bool done_before_use{false};
+  backend::enqueue(g2, [&]() { done_before_use = done; });
+  EXPECT_EQ(backend::synchronize_stream(g2), cudaSuccess);
+  EXPECT_TRUE(done_before_use);
+
+  mr.deallocate(p2, one_mib, cuda_stream_view{g2});
+}
+
+TEST(HostStreamBackendTest, ArenaAllocatesOnSimulatedStreams)
+{
+  rmm::mr::simulated_memory_resource upstream{64 * one_mib};
+  host_arena_mr mr{&upstream, 64 * one_mib, 64 * one_mib};
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    ptrs.push_back(mr.allocate(4096, cuda_stream_view{(i % 2 == 0) ? s1 : s2}));
+  }
+  for (int i = 0; i < 100; ++i) {
+    mr.deallocate(ptrs[i], 4096, cuda_stream_view{(i % 2 == 0) ? s1 : s2});
+  }
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace rmm
@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 
+#include <rmm/cuda_stream.hpp>
 #include <rmm/detail/error.hpp>
 #include <rmm/device_buffer.hpp>
 #include <rmm/mr/device/cuda_memory_resource.hpp>
+#include <rmm/mr/device/detail/deferred_coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/tlsf_free_list.hpp>
 #include <rmm/mr/device/device_memory_resource.hpp>
 #include <rmm/mr/device/per_device_resource.hpp>
 #include <rmm/mr/device/pool_memory_resource.hpp>
@@ -25,6 +28,10 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 namespace rmm {
 namespace test {
 namespace {
@@ -85,6 +92,311 @@ TEST(PoolTest, ForceGrowth)
   EXPECT_THROW(mr.allocate(2000), rmm::bad_alloc);  // too much
 }
 
+TEST(PoolTest, TrimReleasesFreeUpstreamBlocks)
+{
+  cuda_mr cuda;
+  limiting_mr limiter{&cuda, 1 << 20};
+  pool_mr mr{&limiter, 0};
+
+  // Each allocation grows the pool by a new upstream block: 1024 + 4096 + 5120 bytes
+  auto p1 = mr.allocate(1000);
+  auto p2 = mr.allocate(4000);
+  auto p3 = mr.allocate(2000);
+  EXPECT_EQ(mr.pool_size(), 10240);
+  EXPECT_EQ(limiter.get_allocated_bytes(), mr.pool_size());
+
+  mr.deallocate(p2, 4000);
+  mr.deallocate(p3, 2000);
+  EXPECT_EQ(mr.shrink_to_fit(), 9216);  // the block holding p1 is still in use
+  EXPECT_EQ(mr.pool_size(), 1024);
+  EXPECT_EQ(limiter.get_allocated_bytes(), 1024);
+
+  mr.deallocate(p1, 1000);
+  EXPECT_EQ(mr.trim(1024), 0);  // already at the target size
+  EXPECT_EQ(mr.trim(0), 1024);
+  EXPECT_EQ(mr.pool_size(), 0);
+  EXPECT_EQ(limiter.get_allocated_bytes(), 0);
+
+  // The pool grows again on demand
+  void* p{};
+  EXPECT_NO_THROW(p = mr.allocate(1000));
+  EXPECT_EQ(limiter.get_allocated_bytes(), mr.pool_size());
+  mr.deallocate(p, 1000);
+}
+
+TEST(PoolTest, DeferredCoalescing)
+{
+  using deferred_pool_mr =
+    rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource,
+                                  rmm::mr::detail::deferred_coalescing_free_list<>>;
+  cuda_mr cuda;
+  limiting_mr limiter{&cuda, 1 << 20};
+  deferred_pool_mr mr{&limiter, 0};
+
+  auto p1 = mr.allocate(1000);
+  auto p2 = mr.allocate(4000);
+  mr.deallocate(p2, 4000);
+  EXPECT_EQ(mr.allocate(4000), p2);  // reused from the unsorted bin
+  mr.deallocate(p2, 4000);
+
+  // Trimming sees the blocks that were not yet coalesced
+  EXPECT_EQ(mr.shrink_to_fit(), 4096);
+  mr.deallocate(p1, 1000);
+  EXPECT_EQ(mr.shrink_to_fit(), 1024);
+  EXPECT_EQ(mr.pool_size(), 0);
+}
+
+TEST(PoolTest, MinimumSplitSize)
+{
+  cuda_mr cuda;
+  pool_mr mr{&cuda, 4096};
+  mr.set_minimum_split_size(1024);
+
+  // A 512-byte remainder is not split off
+  auto p = mr.allocate(3500);
+  EXPECT_EQ(mr.get_tail_padding_bytes(), 512);
+  EXPECT_EQ(mr.get_avoided_split_count(), 1);
+  EXPECT_EQ(mr.get_allocated_bytes(), 4096);
+  EXPECT_EQ(mr.get_free_bytes(), 0);
+
+  mr.deallocate(p, 3500);
+  EXPECT_EQ(mr.get_tail_padding_bytes(), 0);
+  EXPECT_EQ(mr.get_allocated_bytes(), 0);
+  EXPECT_EQ(mr.get_largest_free_block(), 4096);
+
+  // A 2048-byte remainder is
+  p = mr.allocate(2048);
+  EXPECT_EQ(mr.get_tail_padding_bytes(), 0);
+  EXPECT_EQ(mr.get_avoided_split_count(), 1);
+  EXPECT_EQ(mr.get_free_bytes(), 2048);
+  mr.deallocate(p, 2048);
+}
+
+TEST(PoolTest, DualEndedPlacement)
+{
+  using coalescing_pool_mr =
+    rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource,
+                                  rmm::mr::detail::coalescing_free_list>;
+  cuda_mr cuda;
+  coalescing_pool_mr mr{&cuda, 65536};
+  mr.set_placement_policy(rmm::mr::pool_placement_policy::dual_ended(8192));
+  EXPECT_EQ(mr.get_placement_policy().get_large_size(), 8192);
+
+  auto small = static_cast<char*>(mr.allocate(1024));
+  auto large = static_cast<char*>(mr.allocate(16384));
+  EXPECT_EQ(large, small + 65536 - 16384);  // the top of the same upstream block
+  auto next = static_cast<char*>(mr.allocate(2048));
+  EXPECT_EQ(next, small + 1024);
+  EXPECT_EQ(mr.get_largest_free_block(), 65536 - 16384 - 3072);
+
+  // Freeing the small allocations leaves the free memory below the large one in one block
+  mr.deallocate(small, 1024);
+  mr.deallocate(next, 2048);
+  EXPECT_EQ(mr.get_largest_free_block(), 65536 - 16384);
+
+  mr.deallocate(large, 16384);
+  EXPECT_EQ(mr.get_largest_free_block(), 65536);
+  EXPECT_EQ(mr.shrink_to_fit(), 65536);
+}
+
+TEST(PoolTest, DualEndedPlacementRequiresAddressOrder)
+{
+  cuda_mr cuda;
+  rmm::mr::pool_memory_resource<rmm::mr::device_memory_resource,
+                                rmm::mr::detail::tlsf_free_list>
+    mr{&cuda, 4096};
+  EXPECT_THROW(mr.set_placement_policy(rmm::mr::pool_placement_policy::dual_ended(8192)),
+               rmm::logic_error);
+  EXPECT_NO_THROW(mr.set_placement_policy(rmm::mr::pool_placement_policy::best_fit()));
+}
+
+TEST(PoolTest, LargeAllocationsBypassPool)
+{
+  cuda_mr cuda;
+  limiting_mr limiter{&cuda, 1 << 20};
+  pool_mr mr{&limiter, 4096};
+  mr.set_large_allocation_threshold(8192);
+
+  auto p = mr.allocate(102400);
+  EXPECT_EQ(mr.pool_size(), 4096);
+  EXPECT_EQ(mr.get_allocated_bytes(), 0);
+  EXPECT_EQ(mr.get_large_allocated_bytes(), 102400);
+  EXPECT_EQ(limiter.get_allocated_bytes(), 4096 + 102400);
+  auto small = mr.allocate(8192);  // not above the threshold, so grows the pool
+  EXPECT_GT(mr.pool_size(), 4096);
+  mr.deallocate(small, 8192);
+  auto const pool_size = mr.pool_size();
+
+  mr.deallocate(p, 102400);
+  EXPECT_EQ(mr.get_large_allocated_bytes(), 0);
+  EXPECT_EQ(limiter.get_allocated_bytes(), pool_size);
+
+  // Cached large allocations are reused for the same size
+  mr.set_large_allocation_cache_size(1 << 18);
+  p = mr.allocate(102400);
+  mr.deallocate(p, 102400);
+  EXPECT_EQ(mr.get_large_cached_bytes(), 102400);
+  EXPECT_EQ(mr.allocate(102400), p);
+  EXPECT_EQ(mr.get_large_cached_bytes(), 0);
+  auto q = mr.allocate(204800);
+  mr.deallocate(p, 102400);
+  mr.deallocate(q, 204800);  // evicts p to fit
+  EXPECT_EQ(mr.get_large_cached_bytes(), 204800);
+  EXPECT_EQ(limiter.get_allocated_bytes(), pool_size + 204800);
+
+  mr.set_large_allocation_cache_size(0);
+  EXPECT_EQ(mr.get_large_cached_bytes(), 0);
+  EXPECT_EQ(limiter.get_allocated_bytes(), pool_size);
+}
+
+TEST(PoolTest, BackgroundRefill)
+{
+  cuda_mr cuda;
+  limiting_mr limiter{&cuda, 1 << 20};
+  pool_mr mr{&limiter, 0, 32768};
+
+  auto wait_for_pool_size = [](pool_mr const& pool, std::size_t bytes) {
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (pool.pool_size() < bytes && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    return pool.get_free_bytes();
+  };
+
+  EXPECT_THROW(mr.set_background_refill(1024, 2048), rmm::logic_error);
+
+  // The empty pool is below the low water mark, so it is refilled right away
+  mr.set_background_refill(16384, 4096);
+  EXPECT_EQ(wait_for_pool_size(mr, 16384), 16384);
+
+  auto p1 = mr.allocate(10000);  // leaves 6144 bytes free
+  auto p2 = mr.allocate(4096);   // leaves 2048 bytes free, so the pool is refilled
+  EXPECT_EQ(wait_for_pool_size(mr, 30720), 16384);
+  EXPECT_EQ(mr.get_fast_path_count(), 2);
+  EXPECT_EQ(mr.get_blocking_expansion_count(), 0);
+  EXPECT_EQ(mr.get_background_expansion_count(), 2);
+  EXPECT_EQ(mr.get_expansion_sizes(), (std::vector<std::size_t>{16384, 14336}));
+
+  // The refill thread never grows the pool beyond its maximum size
+  auto p3 = mr.allocate(14336);  // leaves 2048 bytes free
+  EXPECT_EQ(wait_for_pool_size(mr, 32768), 4096);
+  EXPECT_EQ(mr.get_expansion_sizes().back(), 2048);
+  EXPECT_EQ(mr.get_blocking_expansion_count(), 0);
+
+  mr.set_background_refill(0, 0);
+  mr.deallocate(p1, 10000);
+  mr.deallocate(p2, 4096);
+  mr.deallocate(p3, 14336);
+
+  // A refill triggered on a non-default stream goes to that stream's free list
+  pool_mr mr2{&limiter, 0, 32768};
+  rmm::cuda_stream stream{};
+  mr2.set_background_refill(16384, 4096);
+  EXPECT_EQ(wait_for_pool_size(mr2, 16384), 16384);
+
+  auto p4 = mr2.allocate(14336, stream);  // taken from the default stream, leaving 2048 free
+  EXPECT_EQ(mr2.get_steal_count(), 1);
+  EXPECT_EQ(wait_for_pool_size(mr2, 30720), 16384);
+  auto p5 = mr2.allocate(8192, stream);
+  EXPECT_EQ(mr2.get_steal_count(), 1);
+  EXPECT_EQ(mr2.get_blocking_expansion_count(), 0);
+
+  mr2.set_background_refill(0, 0);
+  mr2.deallocate(p4, 14336, stream);
+  mr2.deallocate(p5, 8192, stream);
+}
+
+TEST(PoolTest, GrowthPolicies)
+{
+  cuda_mr cuda;
+  limiting_mr limiter{&cuda, 1 << 20};
+  using rmm::mr::pool_growth_policy;
+
+  auto expansions = [&limiter](pool_growth_policy policy,
+                               thrust::optional<std::size_t> maximum_pool_size,
+                               std::vector<std::size_t> const& sizes) {
+    pool_mr mr{&limiter, 0, maximum_pool_size, policy};
+    std::vector<void*> pointers;
+    for (auto size : sizes) {
+      pointers.push_back(mr.allocate(size));
+    }
+    for (std::size_t i = 0; i < sizes.size(); ++i) {
+      mr.deallocate(pointers[i], sizes[i]);
+    }
+    return mr.get_expansion_sizes();
+  };
+
+  using sizes = std::vector<std::size_t>;
+  EXPECT_EQ(expansions(pool_growth_policy::geometric(), thrust::nullopt, {1000, 4000, 2000}),
+            (sizes{1024, 4096, 5120}));
+  EXPECT_EQ(expansions(pool_growth_policy::geometric(), 65536, {1000, 20000, 20000}),
+            (sizes{32768, 20224}));
+  EXPECT_EQ(expansions(pool_growth_policy::exact_fit(), thrust::nullopt, {1000, 4000}),
+            (sizes{1024, 4096}));
+  EXPECT_EQ(expansions(pool_growth_policy::fixed_chunk(4096), thrust::nullopt, {1000, 5000}),
+            (sizes{4096, 8192}));
+  EXPECT_EQ(expansions(pool_growth_policy::fixed_chunk(65536), 8192, {1000}), (sizes{8192}));
+  EXPECT_EQ(expansions(pool_growth_policy::hinted(10000), thrust::nullopt, {1000, 5000, 20000}),
+            (sizes{10240, 20224}));
+
+  EXPECT_THROW(pool_growth_policy::fixed_chunk(0), rmm::logic_error);
+  EXPECT_THROW(pool_growth_policy::fixed_chunk(1000), rmm::logic_error);
+}
+
+TEST(PoolTest, MemInfo)
+{
+  pool_mr mr{rmm::mr::get_current_device_resource(), 1 << 20};
+  EXPECT_TRUE(mr.supports_get_mem_info());
+  auto const one_mib = std::size_t{1} << 20;
+  EXPECT_EQ(mr.get_mem_info(rmm::cuda_stream_view{}), std::make_pair(one_mib, one_mib));
+
+  auto p1 = mr.allocate(1000);  // 1024 bytes after alignment
+  auto p2 = mr.allocate(4096);
+  EXPECT_EQ(mr.get_allocated_bytes(), 5120);
+  EXPECT_EQ(mr.get_free_bytes(), (1 << 20) - 5120);
+  EXPECT_EQ(mr.get_largest_free_block(), (1 << 20) - 5120);
+  EXPECT_EQ(mr.get_mem_info(rmm::cuda_stream_view{}).first, (1 << 20) - 5120);
+
+  mr.deallocate(p1, 1000);  // not contiguous with the remainder of the pool
+  EXPECT_EQ(mr.get_allocated_bytes(), 4096);
+  EXPECT_EQ(mr.get_free_bytes(), (1 << 20) - 4096);
+  EXPECT_EQ(mr.get_largest_free_block(), (1 << 20) - 5120);
+
+  mr.deallocate(p2, 4096);
+  EXPECT_EQ(mr.get_allocated_bytes(), 0);
+  EXPECT_EQ(mr.get_largest_free_block(), 1 << 20);
+}
+
+TEST(PoolTest, CrossStreamStealsAndMerges)
+{
+  auto const one_mib = std::size_t{1} << 20;
+  pool_mr mr{rmm::mr::get_current_device_resource(), one_mib, one_mib};
+  rmm::cuda_stream s1{};
+  rmm::cuda_stream s2{};
+  rmm::cuda_stream s3{};
+
+  // The whole pool starts out in the free list of the default stream
+  auto p1 = mr.allocate(one_mib / 2, s1.view());
+  EXPECT_EQ(mr.get_steal_count(), 1);
+  EXPECT_EQ(mr.get_merge_count(), 1);
+  auto p2 = mr.allocate(one_mib / 2, s2.view());  // the remainder is now in the list of s1
+  EXPECT_EQ(mr.get_steal_count(), 2);
+  EXPECT_EQ(mr.get_merge_count(), 2);
+
+  mr.deallocate(p1, one_mib / 2, s1.view());
+  mr.deallocate(p2, one_mib / 2, s2.view());
+  EXPECT_EQ(mr.get_largest_free_block(), one_mib / 2);
+
+  // No single stream has a large enough block, so both lists are merged to coalesce one
+  auto p3 = mr.allocate(one_mib, s3.view());
+  EXPECT_EQ(mr.get_steal_count(), 3);
+  EXPECT_EQ(mr.get_merge_count(), 4);
+  EXPECT_EQ(mr.get_largest_free_block(), 0);
+
+  mr.deallocate(p3, one_mib, s3.view());
+  EXPECT_EQ(mr.get_largest_free_block(), one_mib);
+}
+
 TEST(PoolTest, DeletedStream)
 {
   pool_mr mr{rmm::mr::get_current_device_resource(), 0};
@@ -96,6 +408,26 @@ TEST(PoolTest, DeletedStream)
   EXPECT_NO_THROW(mr.allocate(size));
 }
 
+TEST(PoolTest, DestroyedStreamIsReclaimed)
+{
+  auto const one_mib = std::size_t{1} << 20;
+  pool_mr mr{rmm::mr::get_current_device_resource(), one_mib, one_mib};
+
+  void* p{};
+  {
+    rmm::cuda_stream stream{};
+    p = mr.allocate(one_mib, stream.view());
+    mr.deallocate(p, one_mib, stream.view());
+  }
+  EXPECT_EQ(mr.get_reclaim_count(), 1);
+
+  // The block is back in the default stream's free list, so it is not stolen
+  auto const steals = mr.get_steal_count();
+  EXPECT_EQ(mr.allocate(one_mib), p);
+  EXPECT_EQ(mr.get_steal_count(), steals);
+  mr.deallocate(p, one_mib);
+}
+
 // Issue #527
 TEST(PoolTest, InitialAndMaxPoolSizeEqual)
 {
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <rmm/cuda_stream_view.hpp>
+#include <rmm/mr/device/detail/coalescing_free_list.hpp>
+#include <rmm/mr/device/detail/stream_ordered_memory_resource.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rmm {
+namespace test {
+namespace {
+
+/**
+ * @brief A stand-in for `cuda_stream_backend` that records the event operations instead of
+ * performing them.
+ */
+struct recording_backend {
+  enum class op_kind { record, wait };
+
+  struct op {
+    op_kind kind;
+    cudaEvent_t event;
+    cudaStream_t stream;
+  };
+
+  static std::vector<op>& ops()
+  {
+    static std::vector<op> ops_;
+    return ops_;
+  }
+
+  static cudaError_t create_event(cudaEvent_t* event)
+  {
+    static std::uintptr_t next_event{0x1000};
+    *event = reinterpret_cast<cudaEvent_t>(next_event++);
+    return cudaSuccess;
+  }
+
+  static cudaError_t destroy_event(cudaEvent_t) { return cudaSuccess; }
+
+  static cudaError_t record_event(cudaEvent_t event, cudaStream_t stream)
+  {
+    ops().push_back({op_kind::record, event, stream});
+    return cudaSuccess;
+  }
+
+  static cudaError_t stream_wait_event(cudaStream_t stream, cudaEvent_t event)
+  {
+    ops().push_back({op_kind::wait, event, stream});
+    return cudaSuccess;
+  }
+
+  // Work is never known to have completed, so every steal waits
+  static cudaError_t query_event(cudaEvent_t) { return cudaErrorNotReady; }
+
+  static cudaError_t synchronize_event(cudaEvent_t) { return cudaSuccess; }
+
+  static cudaError_t synchronize_stream(cudaStream_t) { return cudaSuccess; }
+};
+
+/**
+ * @brief A minimal stream-ordered resource that suballocates fake (never dereferenced) addresses,
+ * growing by exactly the size requested.
+ */
+class host_stream_ordered_resource;
+
+using host_stream_ordered_base =
+  rmm::mr::detail::stream_ordered_memory_resource<host_stream_ordered_resource,
+                                                  rmm::mr::detail::coalescing_free_list,
+                                                  recording_backend>;
+
+class host_stream_ordered_resource final : public host_stream_ordered_base {
+ public:
+  friend host_stream_ordered_base;
+
+  bool supports_streams() const noexcept override { return true; }
+  bool supports_get_mem_info() const noexcept override { return false; }
+
+ protected:
+  using free_list  = rmm::mr::detail::coalescing_free_list;
+  using block_type = free_list::block_type;
+  using typename host_stream_ordered_base::split_block;
+
+  std::size_t get_maximum_allocation_size() const
+  {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  block_type expand_pool(std::size_t size, free_list&, cuda_stream_view)
+  {
+    block_type b{next_, size, true};
+    next_ += size;
+    return b;
+  }
+
+  split_block allocate_from_block(block_type const& b, std::size_t size)
+  {
+    block_type const alloc{b.pointer(), size, b.is_head()};
+    auto const rest =
+      (b.size() > size) ? block_type{b.pointer() + size, b.size() - size, false} : block_type{};
+    allocated_[alloc.pointer()] = alloc;
+    return {alloc.pointer(), rest};
+  }
+
+  block_type free_block(void* p, std::size_t) noexcept
+  {
+    auto const iter = allocated_.find(static_cast<char*>(p));
+    auto const b    = iter->second;
+    allocated_.erase(iter);
+    return b;
+  }
+
+  std::pair<std::size_t, std::size_t> free_summary() const { return {}; }
+
+  std::pair<std::size_t, std::size_t> do_get_mem_info(cuda_stream_view) const override
+  {
+    return {};
+  }
+
+ private:
+  char* next_{reinterpret_cast<char*>(0x10000)};
+  std::map<char*, block_type> allocated_;
+};
+
+using op_kind = recording_backend::op_kind;
+
+struct StreamOrderedTest : public ::testing::Test {
+  void SetUp() override { recording_backend::ops().clear(); }
+
+  std::size_t count(op_kind kind) const
+  {
+    auto const& ops = recording_backend::ops();
+    return std::count_if(ops.begin(), ops.end(), [kind](auto const& o) { return o.kind == kind; });
+  }
+
+  // Fake stream handles, distinct from the special handles cudaStreamLegacy and cudaStreamPerThread
+  host_stream_ordered_resource mr{};
+  cuda_stream_view const s1{reinterpret_cast<cudaStream_t>(0x100)};
+  cuda_stream_view const s2{reinterpret_cast<cudaStream_t>(0x200)};
+  cuda_stream_view const s3{reinterpret_cast<cudaStream_t>(0x300)};
+};
+
+// Frees `n` blocks of `size` bytes allocated on `stream`
+void allocate_and_free(host_stream_ordered_resource& mr,
+                       cuda_stream_view stream,
+                       std::size_t n,
+                       std::size_t size)
+{
+  std::vector<void*> ptrs;
+  for (std::size_t i = 0; i < n; ++i) {
+    ptrs.push_back(mr.allocate(size, stream));
+  }
+  for (auto p : ptrs) {
+    mr.deallocate(p, size, stream);
+  }
+}
+
+TEST_F(StreamOrderedTest, RecordsOnEveryFreeByDefault)
+{
+  EXPECT_EQ(mr.get_event_record_interval(), 1);
+  allocate_and_free(mr, s1, 3, 256);
+  EXPECT_EQ(count(op_kind::record), 3);
+  EXPECT_EQ(count(op_kind::wait), 0);
+}
+
+TEST_F(StreamOrderedTest, RecordsOncePerBatch)
+{
+  mr.set_event_record_interval(4);
+  allocate_and_free(mr, s1, 10, 256);
+  EXPECT_EQ(count(op_kind::record), 2);
+
+  // Two frees are not yet covered by the event, so it is recorded before s2 waits on it
+  mr.allocate(256, s2);
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 4);
+  EXPECT_EQ(ops[2].kind, op_kind::record);
+  EXPECT_EQ(ops[2].stream, s1.value());
+  EXPECT_EQ(ops[3].kind, op_kind::wait);
+  EXPECT_EQ(ops[3].stream, s2.value());
+  EXPECT_EQ(ops[3].event, ops[2].event);
+}
+
+TEST_F(StreamOrderedTest, RecordsOnlyOnSteal)
+{
+  mr.set_event_record_interval(0);
+  allocate_and_free(mr, s1, 10, 256);
+  EXPECT_EQ(count(op_kind::record), 0);
+
+  mr.allocate(1024, s2);  // merges the free list of s1
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].kind, op_kind::record);
+  EXPECT_EQ(ops[0].stream, s1.value());
+  EXPECT_EQ(ops[1].kind, op_kind::wait);
+  EXPECT_EQ(ops[1].stream, s2.value());
+}
+
+TEST_F(StreamOrderedTest, MergedBlocksAdvanceEpoch)
+{
+  allocate_and_free(mr, s1, 1, 1024);
+  mr.allocate(256, s2);  // s2 waits on s1 and takes the rest of its free list
+
+  // The merged blocks must not be handed to s3 on an event of s2 recorded before the merge
+  recording_backend::ops().clear();
+  mr.allocate(512, s3);
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].kind, op_kind::record);
+  EXPECT_EQ(ops[0].stream, s2.value());
+  EXPECT_EQ(ops[1].kind, op_kind::wait);
+  EXPECT_EQ(ops[1].stream, s3.value());
+}
+
+TEST_F(StreamOrderedTest, GroupSharesFreeList)
+{
+  mr.add_stream_group({s1, s2});
+  auto const p = mr.allocate(1024, s1);
+  mr.deallocate(p, 1024, s1);
+
+  // s2 reuses the block without a steal, waiting on the event of s1
+  recording_backend::ops().clear();
+  EXPECT_EQ(mr.allocate(1024, s2), p);
+  EXPECT_EQ(mr.get_steal_count(), 0);
+  EXPECT_EQ(mr.get_merge_count(), 0);
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 1);
+  EXPECT_EQ(ops[0].kind, op_kind::wait);
+  EXPECT_EQ(ops[0].stream, s2.value());
+
+  // s2 has waited on every free by s1, and need not wait for its own frees
+  mr.deallocate(p, 1024, s2);
+  recording_backend::ops().clear();
+  allocate_and_free(mr, s2, 4, 256);
+  EXPECT_EQ(count(op_kind::wait), 0);
+}
+
+TEST_F(StreamOrderedTest, GroupRecordsOnlyWhenNeeded)
+{
+  mr.set_event_record_interval(0);
+  mr.add_stream_group({s1, s2});
+  allocate_and_free(mr, s1, 4, 256);
+  EXPECT_EQ(count(op_kind::record), 0);
+
+  mr.allocate(256, s2);
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 2);
+  EXPECT_EQ(ops[0].kind, op_kind::record);
+  EXPECT_EQ(ops[0].stream, s1.value());
+  EXPECT_EQ(ops[1].kind, op_kind::wait);
+  EXPECT_EQ(ops[1].stream, s2.value());
+  EXPECT_EQ(ops[1].event, ops[0].event);
+}
+
+TEST_F(StreamOrderedTest, StealFromGroupWaitsOnAllMembers)
+{
+  mr.add_stream_group({s1, s2});
+  allocate_and_free(mr, s1, 1, 256);
+  allocate_and_free(mr, s2, 1, 2048);
+
+  recording_backend::ops().clear();
+  mr.allocate(256, s3);
+  EXPECT_EQ(mr.get_steal_count(), 1);
+  EXPECT_EQ(count(op_kind::wait), 2);
+  for (auto const& o : recording_backend::ops()) {
+    EXPECT_EQ(o.stream, s3.value());
+  }
+}
+
+TEST_F(StreamOrderedTest, GroupRejectsUsedStreams)
+{
+  mr.allocate(256, s1);
+  EXPECT_THROW(mr.add_stream_group({s1, s2}), rmm::logic_error);
+  EXPECT_THROW(mr.add_stream_group({s2, s2}), rmm::logic_error);
+  EXPECT_THROW(mr.add_stream_group({s2, cuda_stream_view{}}), rmm::logic_error);
+  EXPECT_THROW(mr.add_stream_group({}), rmm::logic_error);
+}
+
+TEST_F(StreamOrderedTest, DestroyedStreamIsReclaimedIntoDefaultStream)
+{
+  auto const p = mr.allocate(1024, s1);
+  mr.deallocate(p, 1024, s1);
+  auto const s1_event = recording_backend::ops().back().event;
+
+  recording_backend::ops().clear();
+  mr.on_stream_destroyed(s1);
+  EXPECT_EQ(mr.get_reclaim_count(), 1);
+  auto const& ops = recording_backend::ops();
+  ASSERT_EQ(ops.size(), 1);
+  EXPECT_EQ(ops[0].kind, op_kind::wait);
+  EXPECT_EQ(ops[0].stream, cudaStreamLegacy);
+  EXPECT_EQ(ops[0].event, s1_event);
+
+  // The block is now in the default stream's free list, and the event is reused for s2
+  EXPECT_EQ(mr.allocate(1024, cuda_stream_view{}), p);
+  EXPECT_EQ(mr.get_steal_count(), 0);
+  allocate_and_free(mr, s2, 1, 256);
+  EXPECT_EQ(recording_backend::ops().back().event, s1_event);
+
+  mr.on_stream_destroyed(s3);  // never used
+  EXPECT_EQ(mr.get_reclaim_count(), 1);
+}
+
+TEST_F(StreamOrderedTest, SweepReclaimsIdleStreams)
+{
+  allocate_and_free(mr, s1, 1, 256);
+  allocate_and_free(mr, s2, 1, 256);
+  EXPECT_EQ(mr.sweep_idle_streams(), 0);  // both used since the start
+
+  allocate_and_free(mr, s1, 1, 256);
+  EXPECT_EQ(mr.sweep_idle_streams(), 1);  // s2 is idle
+  EXPECT_EQ(mr.sweep_idle_streams(), 1);  // then s1
+  EXPECT_EQ(mr.get_reclaim_count(), 2);
+
+  // A reclaimed stream that is used again gets a new free list
+  allocate_and_free(mr, s2, 1, 256);
+  EXPECT_EQ(mr.sweep_idle_streams(), 0);
+}
+
+TEST_F(StreamOrderedTest, SweepsAutomatically)
+{
+  mr.set_stream_sweep_interval(2);
+  allocate_and_free(mr, s1, 1, 256);  // first allocation on the slow path
+  mr.allocate(256, s2);               // second sweeps, but s1 was used since the start
+  EXPECT_EQ(mr.get_reclaim_count(), 0);
+  mr.allocate(256, s3);
+  mr.allocate(256, s3);  // fourth sweeps s1 and s2, unused since the second
+  EXPECT_EQ(mr.get_reclaim_count(), 2);
+}
+
+TEST_F(StreamOrderedTest, GroupsAreNotReclaimed)
+{
+  mr.add_stream_group({s1, s2});
+  allocate_and_free(mr, s1, 1, 256);
+  mr.on_stream_destroyed(s1);
+  mr.sweep_idle_streams();
+  EXPECT_EQ(mr.sweep_idle_streams(), 0);
+  EXPECT_EQ(mr.get_reclaim_count(), 0);
+}
+
+TEST_F(StreamOrderedTest, ThreadCacheReusesBlocks)
+{
+  mr.set_thread_cache_size(4096);
+  auto const default_stream = cuda_stream_view{};
+
+  auto* p = mr.allocate(1000, default_stream);
+  mr.deallocate(p, 1000, default_stream);
+  EXPECT_EQ(count(op_kind::record), 0);  // cached, so not freed to the stream's free list
+  EXPECT_EQ(mr.allocate(1000, default_stream), p);
+  EXPECT_EQ(mr.get_thread_cache_hit_count(), 1);
+
+  // Blocks of other sizes and blocks freed on other streams are not taken from the cache
+  mr.deallocate(p, 1000, default_stream);
+  auto* q = mr.allocate(512, default_stream);
+  EXPECT_NE(q, p);
+  mr.deallocate(q, 512, s1);
+  EXPECT_EQ(count(op_kind::record), 1);  // s1 is not cached
+  EXPECT_EQ(mr.get_thread_cache_hit_count(), 1);
+
+  mr.flush_thread_cache();
+  EXPECT_EQ(count(op_kind::record), 2);
+}
+
+TEST_F(StreamOrderedTest, ThreadCacheFlushesOnOverflow)
+{
+  mr.set_thread_cache_size(1024);
+  auto const default_stream = cuda_stream_view{};
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 5; ++i) {
+    ptrs.push_back(mr.allocate(256, default_stream));
+  }
+  for (auto p : ptrs) {
+    mr.deallocate(p, 256, default_stream);
+  }
+  // The fifth block flushes the first four, with a single event record
+  EXPECT_EQ(count(op_kind::record), 1);
+  EXPECT_EQ(mr.allocate(256, default_stream), ptrs.back());
+  EXPECT_EQ(mr.get_thread_cache_hit_count(), 1);
+
+  // Blocks larger than the cache are never cached
+  auto* p = mr.allocate(2048, default_stream);
+  mr.deallocate(p, 2048, default_stream);
+  EXPECT_EQ(count(op_kind::record), 2);
+}
+
+TEST_F(StreamOrderedTest, ThreadCacheFlushesOnThreadExit)
+{
+  mr.set_thread_cache_size(4096);
+  void* p{};
+  std::thread t{[&]() {
+    p = mr.allocate(1024, cuda_stream_per_thread);
+    mr.deallocate(p, 1024, cuda_stream_per_thread);
+  }};
+  t.join();
+  EXPECT_EQ(count(op_kind::record), 1);
+
+  // Flushed to the free list of the exited thread's stream, from which another stream can take it
+  EXPECT_EQ(mr.allocate(1024, s1), p);
+  EXPECT_EQ(mr.get_steal_count(), 1);
+  EXPECT_EQ(mr.get_thread_cache_hit_count(), 0);
+}
+
+}  // namespace
+}  // namespace test
+}  // namespace rmm